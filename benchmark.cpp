@@ -0,0 +1,196 @@
+#include <chrono>
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+#include <scenes.hpp>
+#include <solver.hpp>
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Benchmark
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Runs the built-in scenes at several particle counts and reports their throughput as JSON on stdout (progress goes to stderr).
+// Usage: benchmark [case filter] [threads] [pressure solver] [integrator] [particle-steps] [section.key=value ...]
+// The particle counts come from refining a scene: supportRadius divided by the resolution and mass by its cube keep the density
+// while the blocks (spaced in units of supportRadius) get resolution³ times as many particles. Each case is timed over
+// particle-steps / particles steps (at least MIN_STEPS), after WARMUP_STEPS untimed ones, pass by pass
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+struct BenchmarkCase
+{
+    const char* name;
+    const char* scene;
+    float resolution;
+};
+
+static const BenchmarkCase CASES[]
+{
+    {"blue-fluid-1k",  "blue-fluid", 1.0f},
+    {"blue-fluid-7k",  "blue-fluid", 2.0f},
+    {"blue-fluid-22k", "blue-fluid", 3.0f},
+    {"volcano-1k",     "volcano",    1.0f},
+    {"volcano-9k",     "volcano",    2.0f},
+    {"volcano-30k",    "volcano",    3.0f},
+    {"legacy-8k",      "legacy",     3.0f},
+    {"legacy-39k",     "legacy",     5.0f},
+    // The fountain block is capped at 100000 particles
+    {"legacy-100k",    "legacy",     7.0f}
+};
+
+constexpr unsigned int WARMUP_STEPS {5};
+constexpr unsigned int MIN_STEPS {20};
+
+static const char* const PHASE_NAMES[STEP_PASS_COUNT] {"neighbors", "density", "forces", "timeStep", "pressure", "integrate"};
+
+static std::string overrideValue(const char* key, const float value)
+{
+    std::ostringstream assignment;
+    assignment << key << '=' << std::setprecision(9) << value;
+    return assignment.str();
+}
+
+// stepSPH(), with the time spent in each pass added to phases
+static void timedStep(SPH_State& sim, double phases[STEP_PASS_COUNT])
+{
+    using Clock = std::chrono::steady_clock;
+    auto last = Clock::now();
+    stepSPH(sim, [&](const StepPass pass)
+    {
+        const auto now = Clock::now();
+        phases[static_cast<unsigned int>(pass)] += std::chrono::duration<double>(now - last).count();
+        last = now;
+    });
+}
+
+// Pairs closer than supportRadius, over the current neighbor lists
+static unsigned long long countNeighbors(const SPH_State& sim)
+{
+    const ParticleSoA& ps {sim.particles};
+    const float h2 {sim.supportRadius * sim.supportRadius};
+    unsigned long long pairs {0};
+    for(unsigned int i = 0; i < ps.size(); ++i)
+    {
+        sim.neighbors.forEachNeighbor(i, [&](const unsigned int j)
+        {
+            const float dx {ps.x[i] - ps.x[j]};
+            const float dy {ps.y[i] - ps.y[j]};
+            const float dz {ps.z[i] - ps.z[j]};
+            if(j != i && dx * dx + dy * dy + dz * dz < h2)
+            {
+                ++pairs;
+            }
+        });
+    }
+    return pairs;
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<std::string> overrides;
+    const std::vector<std::string> args {sceneArguments(argc, argv, overrides)};
+    const std::string filter {args.size() > 0 && args[0] != "all" ? args[0] : ""};
+    const unsigned int nThreads {args.size() > 1 ? static_cast<unsigned int>(std::strtoul(args[1].c_str(), nullptr, 10)) : 0u};
+    const double particleSteps {args.size() > 4 ? std::strtod(args[4].c_str(), nullptr) : 2e6};
+
+    std::cout << "{\n  \"cases\": [";
+    bool first {true};
+    for(const BenchmarkCase& benchmark : CASES)
+    {
+        if(std::string(benchmark.name).find(filter) == std::string::npos)
+        {
+            continue;
+        }
+
+        // Loaded once for the parameters to refine, then with the refined ones (and the command line overrides on top)
+        SPH_State sim;
+        std::string error;
+        if(!loadScene(sim, benchmark.scene, {}, error))
+        {
+            std::cerr << "Cannot load scene '" << benchmark.scene << "': " << error << std::endl;
+            return EXIT_FAILURE;
+        }
+        std::vector<std::string> refined {overrideValue("fluid.supportRadius", sim.supportRadius / benchmark.resolution),
+                                          overrideValue("fluid.mass", sim.mass / (benchmark.resolution * benchmark.resolution * benchmark.resolution))};
+        refined.insert(refined.end(), overrides.begin(), overrides.end());
+        if(!loadScene(sim, benchmark.scene, refined, error))
+        {
+            std::cerr << "Cannot load scene '" << benchmark.scene << "': " << error << std::endl;
+            return EXIT_FAILURE;
+        }
+        sim.nThreads = nThreads;
+        if(args.size() > 2 && !setPressureSolver(sim, args[2]))
+        {
+            std::cerr << "Unknown pressure solver '" << args[2] << "' (available: " << PRESSURE_SOLVER_NAMES << ")" << std::endl;
+            return EXIT_FAILURE;
+        }
+        if(args.size() > 3 && !setIntegrator(sim, args[3]))
+        {
+            std::cerr << "Unknown integrator '" << args[3] << "' (available: " << INTEGRATOR_NAMES << ")" << std::endl;
+            return EXIT_FAILURE;
+        }
+        initSolver(sim);
+
+        const unsigned int nParticles {sim.particles.size()};
+        const unsigned int nSteps {std::max(MIN_STEPS, static_cast<unsigned int>(particleSteps / std::max(1u, nParticles)))};
+        std::cerr << benchmark.name << ": " << nParticles << " particles, " << nSteps << " steps on " << sim.pool.size() << " threads" << std::flush;
+
+        double phases[STEP_PASS_COUNT] {};
+        for(unsigned int step = 0; step < WARMUP_STEPS; ++step)
+        {
+            timedStep(sim, phases);
+        }
+        std::fill(phases, phases + STEP_PASS_COUNT, 0.0);
+        const unsigned int rebuilds {sim.neighbors.rebuilds()};
+        const double startTime {sim.time};
+        unsigned long long iterations {0};
+        unsigned long long entries {0};
+        const auto start = std::chrono::steady_clock::now();
+        for(unsigned int step = 0; step < nSteps; ++step)
+        {
+            timedStep(sim, phases);
+            iterations += sim.pressureStats.iterations + sim.pressureStats.divergenceIterations;
+            entries += sim.neighbors.entries();
+        }
+        const double seconds {std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()};
+        const double steps {static_cast<double>(nSteps)};
+        const double nsPerParticleStep {1e9 / (steps * std::max(1u, nParticles))};
+        std::cerr << ", " << seconds * nsPerParticleStep << " ns per particle-step" << std::endl;
+
+        std::cout << (first ? "\n" : ",\n") << "    {\n"
+                  << "      \"name\": \"" << benchmark.name << "\",\n"
+                  << "      \"scene\": \"" << benchmark.scene << "\",\n"
+                  << "      \"resolution\": " << benchmark.resolution << ",\n"
+                  << "      \"particles\": " << nParticles << ",\n"
+                  << "      \"threads\": " << sim.pool.size() << ",\n"
+                  << "      \"simd\": \"" << simdLevelName(sim.simdLevel) << "\",\n"
+                  << "      \"pressureSolver\": \"" << pressureSolverName(sim.pressureSolver) << "\",\n"
+                  << "      \"integrator\": \"" << integratorName(sim.integrator) << "\",\n"
+                  << "      \"steps\": " << nSteps << ",\n"
+                  << "      \"seconds\": " << seconds << ",\n"
+                  << "      \"stepsPerSecond\": " << steps / seconds << ",\n"
+                  << "      \"nsPerParticleStep\": " << seconds * nsPerParticleStep << ",\n"
+                  << "      \"simulatedTime\": " << sim.time - startTime << ",\n"
+                  << "      \"phases\": {";
+        for(unsigned int phase = 0; phase < STEP_PASS_COUNT; ++phase)
+        {
+            std::cout << (phase == 0 ? "\n" : ",\n") << "        \"" << PHASE_NAMES[phase] << "\": {\"seconds\": " << phases[phase]
+                      << ", \"nsPerParticleStep\": " << phases[phase] * nsPerParticleStep << "}";
+        }
+        std::cout << "\n      },\n"
+                  << "      \"pressureIterationsPerStep\": " << iterations / steps << ",\n"
+                  << "      \"neighbors\": {\n"
+                  << "        \"perParticle\": " << static_cast<double>(countNeighbors(sim)) / std::max(1u, nParticles) << ",\n"
+                  << "        \"listEntriesPerParticle\": " << entries / steps / std::max(1u, nParticles) << ",\n"
+                  << "        \"rebuilds\": " << sim.neighbors.rebuilds() - rebuilds << ",\n"
+                  << "        \"stepsPerRebuild\": " << steps / std::max(1u, sim.neighbors.rebuilds() - rebuilds) << "\n"
+                  << "      }\n"
+                  << "    }";
+        first = false;
+    }
+    std::cout << "\n  ]\n}" << std::endl;
+
+    return 0;
+}
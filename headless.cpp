@@ -0,0 +1,166 @@
+#include <chrono>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <iostream>
+
+#include <scenes.hpp>
+#include <solver.hpp>
+#include <checkpoint.hpp>
+#include <frameExport.hpp>
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Headless Runner
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Runs a scene for a fixed number of steps without creating a window or a GL context, and reports the solver throughput.
+// Usage: headless [scene, scene file or checkpoint] [steps] [threads] [pressure solver] [integrator] [checkpoint file]
+//                 [checkpoint interval] [frame file] [frames per second] [quantized|float] [section.key=value ...]
+// A checkpoint resumes the run it was taken from. With a checkpoint file, one is saved every checkpoint interval steps (in the
+// background) and after the last step. With a frame file, the particles are exported at the given rate in simulated time (60 by
+// default, 0 for every step), as 16-bit quantized values (the default) or as floats
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+    std::vector<std::string> overrides;
+    const std::vector<std::string> args {sceneArguments(argc, argv, overrides)};
+    const std::string sceneName {args.size() > 0 ? args[0] : "blue-fluid"};
+    const unsigned int nSteps {args.size() > 1 ? static_cast<unsigned int>(std::strtoul(args[1].c_str(), nullptr, 10)) : 1000u};
+
+    SPH_State sim;
+    std::string error;
+    const bool resuming {isCheckpointFile(sceneName)};
+    if(resuming)
+    {
+        if(!overrides.empty() || !restoreCheckpoint(sim, sceneName, error))
+        {
+            std::cerr << "Cannot restore '" << sceneName << "': " << (overrides.empty() ? error : "parameter overrides only apply to scenes") << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    else if(!loadScene(sim, sceneName, overrides, error))
+    {
+        std::cerr << "Cannot load scene '" << sceneName << "': " << error << " (built-in scenes: " << SCENE_NAMES << ")" << std::endl;
+        return EXIT_FAILURE;
+    }
+    if(args.size() > 2)
+    {
+        sim.nThreads = static_cast<unsigned int>(std::strtoul(args[2].c_str(), nullptr, 10));
+    }
+    if(args.size() > 3 && !setPressureSolver(sim, args[3]))
+    {
+        std::cerr << "Unknown pressure solver '" << args[3] << "' (available: " << PRESSURE_SOLVER_NAMES << ")" << std::endl;
+        return EXIT_FAILURE;
+    }
+    if(args.size() > 4 && !setIntegrator(sim, args[4]))
+    {
+        std::cerr << "Unknown integrator '" << args[4] << "' (available: " << INTEGRATOR_NAMES << ")" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const std::string checkpointPath {args.size() > 5 ? args[5] : ""};
+    const unsigned int checkpointInterval {args.size() > 6 ? static_cast<unsigned int>(std::strtoul(args[6].c_str(), nullptr, 10)) : 0u};
+    const std::string framePath {args.size() > 7 ? args[7] : ""};
+    const double framesPerSecond {args.size() > 8 ? std::strtod(args[8].c_str(), nullptr) : 60.0};
+    const double frameInterval {framesPerSecond > 0.0 ? 1.0 / framesPerSecond : 0.0};
+    const std::string frameEncoding {args.size() > 9 ? args[9] : "quantized"};
+    if(frameEncoding != "quantized" && frameEncoding != "float")
+    {
+        std::cerr << "Unknown frame encoding '" << frameEncoding << "' (available: quantized, float)" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if(resuming)
+    {
+        resumeSolver(sim);
+        std::cout << "Resumed at step " << sim.stepCount << " (" << sim.time << " s simulated)" << std::endl;
+    }
+    else
+    {
+        initSolver(sim);
+    }
+    std::cout << "Initialized '" << sceneName << "' with " << sim.particles.size() << " particles on " << sim.pool.size() << " threads (" << simdLevelName(sim.simdLevel) << ")" << std::endl;
+
+    // A resumed run starts from the restored totals, so the summary reports what this run added to them
+    const double startTime {sim.time};
+    const unsigned int startRebuilds {sim.neighbors.rebuilds()};
+    const auto start = std::chrono::steady_clock::now();
+    unsigned long long iterations {0};
+    unsigned long long divergenceIterations {0};
+    float maxDensityError {0.0f};
+    CheckpointWriter checkpoints;
+    if(!checkpointPath.empty())
+    {
+        checkpoints.start(checkpointPath, checkpointInterval);
+    }
+    FrameWriter frames;
+    double nextFrameTime {sim.time};
+    if(!framePath.empty())
+    {
+        if(!frames.open(framePath, frameEncoding != "float", 30, error))
+        {
+            std::cerr << "Cannot export frames: " << error << std::endl;
+            return EXIT_FAILURE;
+        }
+        frames.add(sim);
+        nextFrameTime += frameInterval;
+    }
+    for(unsigned int step = 0; step < nSteps; ++step)
+    {
+        if(stepSPH(sim))
+        {
+            frames.reorder(sim.permutation);
+        }
+        checkpoints.update(sim);
+        if(!framePath.empty() && sim.time >= nextFrameTime)
+        {
+            frames.add(sim);
+            nextFrameTime = std::max(nextFrameTime + frameInterval, sim.time);
+        }
+        iterations += sim.pressureStats.iterations;
+        divergenceIterations += sim.pressureStats.divergenceIterations;
+        maxDensityError = std::max(maxDensityError, sim.pressureStats.densityError);
+    }
+    const double seconds {std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()};
+    checkpoints.stop();
+    frames.close();
+
+    std::cout << "Ran " << nSteps << " steps in " << seconds << " s (" << nSteps / seconds << " steps/s, "
+              << seconds * 1e9 / (static_cast<double>(nSteps) * sim.particles.size()) << " ns per particle-step)" << std::endl;
+    const double simulated {sim.time - startTime};
+    std::cout << "Simulated " << simulated << " s (" << (sim.adaptiveTimeStep ? "adaptive" : "fixed") << " timeStep, "
+              << simulated / std::max(1u, nSteps) * 1e3 << " ms on average)" << std::endl;
+    if(!usesStateEquation(sim))
+    {
+        std::cout << "Pressure solve: " << static_cast<double>(iterations) / std::max(1u, nSteps) << " iterations per step, density error up to "
+                  << maxDensityError * 100.0f << "%";
+        if(sim.pressureSolver == PressureSolver::DFSPH)
+        {
+            std::cout << " (divergence solve: " << static_cast<double>(divergenceIterations) / std::max(1u, nSteps) << " iterations per step)";
+        }
+        std::cout << std::endl;
+    }
+    const unsigned int rebuilds {sim.neighbors.rebuilds() - startRebuilds};
+    std::cout << "Neighbor lists: " << rebuilds << " rebuilds (every " << static_cast<double>(nSteps) / std::max(1u, rebuilds)
+              << " steps), " << sim.neighbors.entries() << " entries, " << sim.neighbors.memoryBytes() / 1024 << " KiB" << std::endl;
+    if(sim.pairCache.memoryBytes() > 0u)
+    {
+        std::cout << "Pair cache: " << sim.pairCache.memoryBytes() / 1024 << " KiB" << std::endl;
+    }
+    if(!framePath.empty())
+    {
+        std::cout << "Frames: " << frames.frames() << " written to '" << framePath << "', " << frames.writtenBytes() / 1024 << " KiB ("
+                  << static_cast<double>(frames.rawBytes()) / std::max<std::uint64_t>(1u, frames.writtenBytes()) << "x smaller than floats)" << std::endl;
+    }
+    if(!checkpointPath.empty())
+    {
+        if(!writeCheckpoint(sim, checkpointPath, error))
+        {
+            std::cerr << "Cannot save the checkpoint: " << error << std::endl;
+            return EXIT_FAILURE;
+        }
+        std::cout << "Checkpoints: " << checkpoints.written() + 1u << " written to '" << checkpointPath << "' (the last at step " << sim.stepCount << ")" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,171 @@
+#ifndef CHECKPOINT_HPP
+#define CHECKPOINT_HPP
+
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <condition_variable>
+
+#include <solver.hpp>
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Checkpoints
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Binary snapshots of a running simulation: the parameters, the particles and what the solver carries from one step to the next
+// (step counter, simulated time, warm starts, half-step velocities, neighbor lists), so a restored run goes on exactly as the
+// saved one would have. A file is a 64-byte header, a table of sections, then the sections, each one a raw array starting on a
+// 64-byte boundary: mapped in memory, they are used as they are. SPH_Params is stored as is, so a checkpoint is only read back by
+// a build with the same CHECKPOINT_VERSION and the same parameter layout
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Bump whenever what a section holds changes
+constexpr std::uint32_t CHECKPOINT_VERSION {1};
+
+enum class CheckpointSection : std::uint32_t
+{
+    PARAMETERS,
+    SOLVER_STATE,
+    // ParticleSoA
+    X, Y, Z,
+    VX, VY, VZ,
+    FX, FY, FZ,
+    DENSITY,
+    PRESSURE,
+    COLOR,
+    // IntegratorData
+    HALF_STEP_VX, HALF_STEP_VY, HALF_STEP_VZ,
+    PREVIOUS_AX, PREVIOUS_AY, PREVIOUS_AZ,
+    // PressureSolverData warm starts
+    KAPPA,
+    KAPPA_V,
+    // NeighborList
+    LIST_OFFSETS,
+    LIST_INDICES,
+    LIST_X0, LIST_Y0, LIST_Z0
+};
+
+struct CheckpointHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t parametersSize;
+    std::uint32_t particleCount;
+    std::uint32_t sectionCount;
+    std::uint64_t fileSize;
+    // Name of the boundary function (boundaryName())
+    char boundary[32];
+};
+
+struct CheckpointSectionEntry
+{
+    CheckpointSection id;
+    std::uint32_t elementSize;
+    std::uint64_t offset;
+    std::uint64_t count;
+};
+
+// Read-only memory mapping of a checkpoint, checked on open()
+class CheckpointFile
+{
+public:
+    CheckpointFile() = default;
+
+    CheckpointFile(const CheckpointFile&) = delete;
+    CheckpointFile& operator=(const CheckpointFile&) = delete;
+
+    ~CheckpointFile()
+    {
+        close();
+    }
+
+    bool open(const std::string& path, std::string& error);
+    void close();
+
+    const CheckpointHeader& header() const
+    {
+        return *reinterpret_cast<const CheckpointHeader*>(m_data);
+    }
+
+    // Elements of a section, in place in the mapping, nullptr (and count 0) if the checkpoint has none or stores it with elements
+    // of another size than elementSize
+    const void* section(CheckpointSection id, std::size_t elementSize, std::size_t& count) const;
+
+private:
+    const unsigned char* m_data {nullptr};
+    std::size_t m_size {0};
+#ifdef _WIN32
+    void* m_file {nullptr};
+    void* m_mapping {nullptr};
+#endif
+};
+
+// True when path starts like a checkpoint
+bool isCheckpointFile(const std::string& path);
+
+// Writes a checkpoint of sim, between two steps
+bool writeCheckpoint(const SPH_State& sim, const std::string& path, std::string& error);
+
+// Sets the parameters, the particles and the solver state of a checkpoint, each array copied straight from the mapped file. Like
+// loadScene(), callers can override parameters (e.g. nThreads) afterwards, then call resumeSolver() (not initSolver(), which
+// would start the run over)
+bool restoreCheckpoint(SPH_State& sim, const std::string& path, std::string& error);
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Checkpoint Writer
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Periodic checkpoints written on a thread of their own: the step loop only waits for the state to be copied into a file image,
+// which the thread writes to path.tmp and then renames over path, so a crash mid-write leaves the previous checkpoint intact.
+// A checkpoint due while the previous one is still being written is skipped rather than waited for
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+class CheckpointWriter
+{
+public:
+    CheckpointWriter() = default;
+
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+    ~CheckpointWriter()
+    {
+        stop();
+    }
+
+    // Saves to path every interval steps (of sim.stepCount)
+    void start(const std::string& path, unsigned int interval);
+    // Waits for the checkpoint being written, if any
+    void stop();
+
+    // Call after every step. Returns true when a checkpoint was taken
+    bool update(const SPH_State& sim);
+    // Takes a checkpoint now, unless one is still being written
+    bool save(const SPH_State& sim);
+
+    // Checkpoints written so far, and why the last one failed (empty if none did)
+    unsigned int written() const
+    {
+        return m_written.load(std::memory_order_relaxed);
+    }
+
+    std::string lastError();
+
+private:
+    void run();
+
+    std::string m_path;
+    unsigned int m_interval {0};
+
+    std::vector<unsigned char> m_image;
+    std::string m_error;
+    bool m_pending {false};
+    bool m_quit {false};
+    std::atomic<unsigned int> m_written {0};
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::thread m_thread;
+};
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+#endif // CHECKPOINT_HPP
@@ -0,0 +1,188 @@
+#ifndef FRAME_EXPORT_HPP
+#define FRAME_EXPORT_HPP
+
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <fstream>
+#include <condition_variable>
+
+#include <solver.hpp>
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Frame Files
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Particle positions, velocities and densities of a sequence of frames, for offline rendering. A file is a header, one chunk per
+// frame, then an index of the chunks (the footer) and a trailer pointing to it, so frame k is read without going through the
+// others. Particles are stored by id (their order when first exported), which survives the solver reordering them.
+//
+// A chunk holds the 7 fields one after the other, each one as 16-bit values spread over a range (quantized) or as floats.
+// Between keyframes, a field is stored as its change since the previous frame (zigzag differences of the quantized values, XOR
+// of the float bits), and every field is split into byte planes before the whole chunk goes through a byte-oriented LZ77 coder,
+// which turns the mostly-zero high bytes into a few matches. The ranges stay fixed from one keyframe to the next, so a particle
+// at rest keeps its quantized values and stores zeros: positions span the domain box (and any splash outside it), velocities
+// and densities their extent at the keyframe with some headroom. A frame that leaves a range becomes a keyframe, which widens it
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Bump whenever the layout of a chunk or of the index changes
+constexpr std::uint32_t FRAME_FILE_VERSION {1};
+constexpr unsigned int FRAME_FIELDS {7};
+
+struct FrameFileHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t flags;
+    std::uint32_t keyframeInterval;
+    std::uint32_t reserved;
+};
+
+struct FrameChunkHeader
+{
+    char magic[4];
+    std::uint32_t flags;
+    std::uint32_t frame;
+    std::uint32_t step;
+    double time;
+    std::uint32_t count;
+    // Size of the fields once decompressed, and as stored
+    std::uint32_t rawSize;
+    std::uint32_t storedSize;
+    std::uint32_t reserved;
+    // Range of each field (x, y, z, vx, vy, vz, density) the quantized values span, the same from one keyframe to the next (the
+    // extent of the frame with floats)
+    float minimum[FRAME_FIELDS];
+    float maximum[FRAME_FIELDS];
+};
+
+struct FrameIndexEntry
+{
+    std::uint64_t offset;
+    double time;
+    std::uint32_t step;
+    std::uint32_t flags;
+};
+
+// One frame, fields in particle id order
+struct ExportedFrame
+{
+    unsigned int step;
+    double time;
+    unsigned int count;
+    // x, y, z, vx, vy, vz, density
+    std::vector<float> fields[FRAME_FIELDS];
+    // Domain box, from the origin to (boundaryWidth, boundaryHeight, boundaryDepth), for the writer to quantize positions over
+    float domain[3] {};
+};
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Frame Writer
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Streams frames to a file from a thread of its own: add() only copies the fields it exports (in id order) and queues them, the
+// thread encodes and writes them. Exporting has to keep every frame, so add() waits when MAX_QUEUED frames are already queued
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+class FrameWriter
+{
+public:
+    static constexpr unsigned int MAX_QUEUED {4};
+
+    FrameWriter() = default;
+
+    FrameWriter(const FrameWriter&) = delete;
+    FrameWriter& operator=(const FrameWriter&) = delete;
+
+    ~FrameWriter()
+    {
+        close();
+    }
+
+    // A keyframe every keyframeInterval frames (1 stores every frame on its own)
+    bool open(const std::string& path, bool quantize, unsigned int keyframeInterval, std::string& error);
+    // Writes the queued frames and the index
+    void close();
+
+    void add(const SPH_State& sim);
+    // Call when stepSPH() reordered the particles, so their ids follow them
+    void reorder(const std::vector<unsigned int>& permutation);
+
+    // Frames written so far, their size as floats and as written
+    unsigned int frames();
+    std::uint64_t rawBytes();
+    std::uint64_t writtenBytes();
+
+private:
+    void run();
+    void encode(ExportedFrame& frame, std::vector<unsigned char>& chunk);
+
+    std::ofstream m_file;
+    bool m_quantize {true};
+    unsigned int m_keyframeInterval {1};
+
+    // Id of the particle at each index
+    std::vector<unsigned int> m_ids;
+
+    // Written by the thread only: the stored values of the previous frame, the index and the encoder scratch space
+    std::vector<std::uint32_t> m_previous[FRAME_FIELDS];
+    unsigned int m_previousCount {0};
+    // Ranges of the quantized values since the last keyframe
+    float m_minimum[FRAME_FIELDS] {};
+    float m_maximum[FRAME_FIELDS] {};
+    std::vector<FrameIndexEntry> m_index;
+    std::uint64_t m_offset {0};
+    std::vector<std::uint32_t> m_values;
+    std::vector<unsigned char> m_raw;
+    std::vector<unsigned char> m_packed;
+    std::vector<std::uint32_t> m_table;
+
+    std::deque<ExportedFrame> m_queue;
+    std::vector<ExportedFrame> m_free;
+    unsigned int m_frames {0};
+    std::uint64_t m_rawBytes {0};
+    std::uint64_t m_writtenBytes {0};
+    bool m_quit {false};
+    std::mutex m_mutex;
+    std::condition_variable m_queued;
+    std::condition_variable m_dequeued;
+    std::thread m_thread;
+};
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Frame Reader
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Random access to the frames of a file, through its index, or through its chunks when the writer did not get to close it
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+class FrameReader
+{
+public:
+    bool open(const std::string& path, std::string& error);
+
+    unsigned int frameCount() const
+    {
+        return static_cast<unsigned int>(m_index.size());
+    }
+
+    const FrameIndexEntry& entry(const unsigned int k) const
+    {
+        return m_index[k];
+    }
+
+    // Decodes frame k (and the frames since the keyframe before it, unless they were the last ones read)
+    bool read(unsigned int k, ExportedFrame& frame, std::string& error);
+
+private:
+    bool readChunk(unsigned int k, FrameChunkHeader& header, std::vector<unsigned char>& raw, std::string& error);
+
+    std::ifstream m_file;
+    bool m_quantize {true};
+    std::vector<FrameIndexEntry> m_index;
+
+    // Stored values of the last frame decoded, the base of the next one
+    std::vector<std::uint32_t> m_previous[FRAME_FIELDS];
+    unsigned int m_previousFrame {~0u};
+};
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+#endif // FRAME_EXPORT_HPP
@@ -0,0 +1,223 @@
+#ifndef GRID_HPP
+#define GRID_HPP
+
+#include <HSGIL/math/vec3.hpp>
+
+#include <vector>
+#include <cmath>
+#include <iterator>
+#include <algorithm>
+
+#include <particle.hpp>
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Uniform Grid
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Cells of size h are hashed into a power-of-two table and particles are counting-sorted by bucket, so a rebuild is O(N) and
+// the grid never depends on the domain extents (the volcano and legacy scenes are not bounded by a box). A query visits the
+// 27 cells around a position; the caller still has to check the distance, as two far cells may share a bucket.
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+class UniformGrid
+{
+public:
+    void build(const ParticleSoA& particles, const float cellSize)
+    {
+        const unsigned int nParticles {particles.size()};
+        m_invCellSize = 1.0f / cellSize;
+
+        unsigned int tableSize {1u};
+        while(tableSize < 2u * nParticles)
+        {
+            tableSize <<= 1;
+        }
+        m_mask = tableSize - 1u;
+
+        m_cellStart.assign(tableSize + 1u, 0u);
+        m_particleCell.resize(nParticles);
+        m_sortedIndices.resize(nParticles);
+
+        for(unsigned int i = 0; i < nParticles; ++i)
+        {
+            const gil::Vec3i c {cellCoord(particles.x[i], particles.y[i], particles.z[i])};
+            m_particleCell[i] = hash(c.x, c.y, c.z);
+            ++m_cellStart[m_particleCell[i] + 1u];
+        }
+        for(unsigned int b = 0; b < tableSize; ++b)
+        {
+            m_cellStart[b + 1u] += m_cellStart[b];
+        }
+
+        m_cellFill.assign(m_cellStart.begin(), m_cellStart.end() - 1);
+        for(unsigned int i = 0; i < nParticles; ++i)
+        {
+            m_sortedIndices[m_cellFill[m_particleCell[i]]++] = i;
+        }
+    }
+
+    // Calls fn(j) once for every particle j lying in the 27 cells around p
+    template <typename F>
+    void forEachNeighbor(const gil::Vec3f& p, F&& fn) const
+    {
+        forEachBucket(p, [&](const unsigned int begin, const unsigned int end)
+        {
+            for(unsigned int s = begin; s < end; ++s)
+            {
+                fn(m_sortedIndices[s]);
+            }
+        });
+    }
+
+    // Computes the permutation that lays particles out along the Z-order curve of their cells. Morton keys are radix sorted
+    // 8 bits at a time (one counting sort per pass), and only as many passes as the occupied cell range needs are run
+    void zOrderPermutation(const ParticleSoA& particles, const float cellSize, std::vector<unsigned int>& permutation)
+    {
+        const unsigned int nParticles {particles.size()};
+        m_invCellSize = 1.0f / cellSize;
+        permutation.resize(nParticles);
+        if(nParticles == 0)
+        {
+            return;
+        }
+
+        std::vector<gil::Vec3i> cells(nParticles);
+        gil::Vec3i minCell {cellCoord(particles.x[0], particles.y[0], particles.z[0])};
+        gil::Vec3i maxCell {minCell};
+        for(unsigned int i = 0; i < nParticles; ++i)
+        {
+            cells[i] = cellCoord(particles.x[i], particles.y[i], particles.z[i]);
+            minCell = {std::min(minCell.x, cells[i].x), std::min(minCell.y, cells[i].y), std::min(minCell.z, cells[i].z)};
+            maxCell = {std::max(maxCell.x, cells[i].x), std::max(maxCell.y, cells[i].y), std::max(maxCell.z, cells[i].z)};
+        }
+
+        const unsigned int extent {static_cast<unsigned int>(std::max({maxCell.x - minCell.x, maxCell.y - minCell.y, maxCell.z - minCell.z}))};
+        unsigned int axisBits {0};
+        while(axisBits < MORTON_AXIS_BITS && (extent >> axisBits) != 0)
+        {
+            ++axisBits;
+        }
+
+        std::vector<unsigned long long> keys(nParticles);
+        std::vector<unsigned long long> sortedKeys(nParticles);
+        std::vector<unsigned int> scratch(nParticles);
+        for(unsigned int i = 0; i < nParticles; ++i)
+        {
+            keys[i] = morton(cells[i].x - minCell.x, cells[i].y - minCell.y, cells[i].z - minCell.z);
+            permutation[i] = i;
+        }
+
+        unsigned int counts[257];
+        for(unsigned int shift = 0; shift < 3u * axisBits; shift += 8u)
+        {
+            std::fill(std::begin(counts), std::end(counts), 0u);
+            for(unsigned int i = 0; i < nParticles; ++i)
+            {
+                ++counts[((keys[i] >> shift) & 0xFFu) + 1u];
+            }
+            for(unsigned int d = 0; d < 256u; ++d)
+            {
+                counts[d + 1u] += counts[d];
+            }
+            for(unsigned int i = 0; i < nParticles; ++i)
+            {
+                const unsigned int slot {counts[(keys[i] >> shift) & 0xFFu]++};
+                sortedKeys[slot] = keys[i];
+                scratch[slot] = permutation[i];
+            }
+            keys.swap(sortedKeys);
+            permutation.swap(scratch);
+        }
+    }
+
+private:
+    // Calls fn(begin, end) with the m_sortedIndices range of every distinct bucket among the 27 cells around p
+    template <typename F>
+    void forEachBucket(const gil::Vec3f& p, F&& fn) const
+    {
+        const gil::Vec3i c {cellCoord(p.x, p.y, p.z)};
+
+        unsigned int buckets[27];
+        unsigned int nBuckets {0};
+        for(int dz = -1; dz <= 1; ++dz)
+        {
+            for(int dy = -1; dy <= 1; ++dy)
+            {
+                for(int dx = -1; dx <= 1; ++dx)
+                {
+                    const unsigned int b {hash(c.x + dx, c.y + dy, c.z + dz)};
+
+                    bool visited {false};
+                    for(unsigned int k = 0; k < nBuckets && !visited; ++k)
+                    {
+                        visited = buckets[k] == b;
+                    }
+                    if(!visited)
+                    {
+                        buckets[nBuckets++] = b;
+                    }
+                }
+            }
+        }
+
+        for(unsigned int k = 0; k < nBuckets; ++k)
+        {
+            fn(m_cellStart[buckets[k]], m_cellStart[buckets[k] + 1u]);
+        }
+    }
+
+    static unsigned long long spreadBits(const unsigned int v)
+    {
+        unsigned long long x {std::min(v, (1u << MORTON_AXIS_BITS) - 1u)};
+        x = (x | (x << 32)) & 0x1F00000000FFFFull;
+        x = (x | (x << 16)) & 0x1F0000FF0000FFull;
+        x = (x | (x << 8))  & 0x100F00F00F00F00Full;
+        x = (x | (x << 4))  & 0x10C30C30C30C30C3ull;
+        x = (x | (x << 2))  & 0x1249249249249249ull;
+        return x;
+    }
+
+    static unsigned long long morton(const int x, const int y, const int z)
+    {
+        return spreadBits(static_cast<unsigned int>(x)) | (spreadBits(static_cast<unsigned int>(y)) << 1) | (spreadBits(static_cast<unsigned int>(z)) << 2);
+    }
+
+    gil::Vec3i cellCoord(const float x, const float y, const float z) const
+    {
+        return {toCell(x), toCell(y), toCell(z)};
+    }
+
+    int toCell(const float v) const
+    {
+        // Clamped so that diverged (huge or NaN) positions still land in a valid cell instead of overflowing the cast
+        const float c {std::floor(v * m_invCellSize)};
+        if(!(c > -MAX_CELL))
+        {
+            return -static_cast<int>(MAX_CELL);
+        }
+        if(c > MAX_CELL)
+        {
+            return static_cast<int>(MAX_CELL);
+        }
+        return static_cast<int>(c);
+    }
+
+    unsigned int hash(const int x, const int y, const int z) const
+    {
+        return ((static_cast<unsigned int>(x) * 73856093u) ^
+                (static_cast<unsigned int>(y) * 19349663u) ^
+                (static_cast<unsigned int>(z) * 83492791u)) & m_mask;
+    }
+
+    static constexpr float MAX_CELL {1048576.0f};
+    static constexpr unsigned int MORTON_AXIS_BITS {21u};
+
+    float m_invCellSize {1.0f};
+    unsigned int m_mask {0u};
+
+    std::vector<unsigned int> m_cellStart;
+    std::vector<unsigned int> m_cellFill;
+    std::vector<unsigned int> m_particleCell;
+    std::vector<unsigned int> m_sortedIndices;
+};
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+#endif // GRID_HPP
@@ -0,0 +1,123 @@
+#ifndef KERNELS_HPP
+#define KERNELS_HPP
+
+#include <HSGIL/math/constants.hpp>
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// SPH Kernels
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Smoothing kernels for a fixed support radius h. The normalization constants are computed once, in the constructor, so a pair
+// evaluation is a handful of multiplications: the caller computes r² (and |r| only when a kernel needs it) once per pair and
+// passes it to every kernel. The constructor is constexpr, so a radius known at compile time gives compile-time constants:
+//     constexpr SPHKernel kernel {16.0f};
+//
+// The gradients return the scalar factor s such that the gradient is s * r, where r = ri - rj.
+// Every kernel expects the pair to be inside the support (r² < h²); the caller does that check.
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+class SPHKernel
+{
+public:
+    constexpr SPHKernel() = default;
+
+    constexpr explicit SPHKernel(const float h)
+        : m_h              {h},
+          m_h2             {h * h},
+          m_poly6          {315.0f / (64.0f * gil::constants::PI * pow9(h))},
+          m_poly6Gradient  {-945.0f / (32.0f * gil::constants::PI * pow9(h))},
+          m_spikyGradient  {-45.0f / (gil::constants::PI * pow6(h))},
+          m_viscosity      {45.0f / (gil::constants::PI * pow6(h))}
+    {
+    }
+
+    constexpr float radius() const
+    {
+        return m_h;
+    }
+
+    constexpr float radius2() const
+    {
+        return m_h2;
+    }
+
+    // Normalization constants, for the vectorized passes that evaluate the kernels several pairs at a time
+    constexpr float poly6Scale() const
+    {
+        return m_poly6;
+    }
+
+    constexpr float poly6GradientScale() const
+    {
+        return m_poly6Gradient;
+    }
+
+    constexpr float spikyGradientScale() const
+    {
+        return m_spikyGradient;
+    }
+
+    constexpr float viscosityScale() const
+    {
+        return m_viscosity;
+    }
+
+    // W(r) = 315 / (64 pi h^9) * (h² - r²)³
+    constexpr float poly6(const float r2) const
+    {
+        const float d {m_h2 - r2};
+        return m_poly6 * d * d * d;
+    }
+
+    // ∇W(r) = -945 / (32 pi h^9) * (h² - r²)² * r
+    constexpr float poly6Gradient(const float r2) const
+    {
+        const float d {m_h2 - r2};
+        return m_poly6Gradient * d * d;
+    }
+
+    // ∇²W(r) = -945 / (32 pi h^9) * (h² - r²) * (3h² - 7r²)
+    constexpr float poly6Laplacian(const float r2) const
+    {
+        return m_poly6Gradient * (m_h2 - r2) * (3.0f * m_h2 - 7.0f * r2);
+    }
+
+    // ∇W(r) = -45 / (pi h^6) * (h - |r|)² * r / |r|, zero for coincident particles (stacked by a boundary), which have no
+    // direction to push each other along
+    constexpr float spikyGradient(const float r) const
+    {
+        if(r == 0.0f)
+        {
+            return 0.0f;
+        }
+        const float d {m_h - r};
+        return m_spikyGradient * d * d / r;
+    }
+
+    // ∇²W(r) = 45 / (pi h^6) * (h - |r|)
+    constexpr float viscosityLaplacian(const float r) const
+    {
+        return m_viscosity * (m_h - r);
+    }
+
+private:
+    static constexpr float pow6(const float h)
+    {
+        const float h3 {h * h * h};
+        return h3 * h3;
+    }
+
+    static constexpr float pow9(const float h)
+    {
+        const float h3 {h * h * h};
+        return h3 * h3 * h3;
+    }
+
+    float m_h             {0.0f};
+    float m_h2            {0.0f};
+    float m_poly6         {0.0f};
+    float m_poly6Gradient {0.0f};
+    float m_spikyGradient {0.0f};
+    float m_viscosity     {0.0f};
+};
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+#endif // KERNELS_HPP
@@ -0,0 +1,301 @@
+#ifndef NEIGHBOR_LIST_HPP
+#define NEIGHBOR_LIST_HPP
+
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+
+#include <grid.hpp>
+#include <particle.hpp>
+#include <threadPool.hpp>
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Neighbor List
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Verlet lists: every particle keeps the indices of the particles within radius = h + skin (itself included), stored back to
+// back in one array (CSR layout). While no particle has moved more than skin / 2 since the build, no pair can have entered
+// the support h unnoticed, so the same lists serve several steps and the density and force passes walk a compact index range
+// instead of hashing 27 cells per particle.
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+class NeighborList
+{
+public:
+    // Rebuilds every list from a grid built with a cell size of at least radius
+    void build(const ParticleSoA& particles, const UniformGrid& grid, const float radius, ThreadPool& pool)
+    {
+        const unsigned int nParticles {particles.size()};
+        const float radius2 {radius * radius};
+
+        m_x0.assign(particles.x.begin(), particles.x.end());
+        m_y0.assign(particles.y.begin(), particles.y.end());
+        m_z0.assign(particles.z.begin(), particles.z.end());
+        m_counts.resize(nParticles);
+        m_offsets.resize(nParticles + 1u);
+        m_threadIndices.resize(pool.size());
+
+        // Each thread lists its own chunk of particles...
+        pool.parallelFor(nParticles, [&](const unsigned int begin, const unsigned int end, const unsigned int thread)
+        {
+            std::vector<unsigned int>& indices {m_threadIndices[thread]};
+            indices.clear();
+            for(unsigned int i = begin; i < end; ++i)
+            {
+                const gil::Vec3f ri {particles.position(i)};
+                const std::size_t first {indices.size()};
+                grid.forEachNeighbor(ri, [&](const unsigned int j)
+                {
+                    const float dx {ri.x - particles.x[j]};
+                    const float dy {ri.y - particles.y[j]};
+                    const float dz {ri.z - particles.z[j]};
+                    if(dx * dx + dy * dy + dz * dz < radius2)
+                    {
+                        indices.push_back(j);
+                    }
+                });
+                m_counts[i] = static_cast<unsigned int>(indices.size() - first);
+            }
+        });
+
+        m_offsets[0] = 0u;
+        for(unsigned int i = 0; i < nParticles; ++i)
+        {
+            m_offsets[i + 1u] = m_offsets[i] + m_counts[i];
+        }
+
+        // ...and, as the chunks are the same for the same size, copies it to where its first particle starts
+        m_indices.resize(m_offsets[nParticles]);
+        pool.parallelFor(nParticles, [&](const unsigned int begin, const unsigned int, const unsigned int thread)
+        {
+            const std::vector<unsigned int>& indices {m_threadIndices[thread]};
+            std::copy(indices.begin(), indices.end(), m_indices.begin() + m_offsets[begin]);
+        });
+
+        m_radius = radius;
+        ++m_rebuilds;
+        m_halvesBuilt = false;
+    }
+
+    // Half lists for the passes that visit every pair once and write both particles, split along the chunks of pool so that no
+    // thread writes outside its own: the list of i first holds the pairs it owns, the j > i of its chunk (halfCount(i)), then
+    // every neighbor outside the chunk (crossCount(i)), whose pairs both chunks visit, each for its own particle only. Derived
+    // from the full lists the first time they are needed after a build (or with another pool size)
+    void buildHalves(ThreadPool& pool)
+    {
+        if(m_halvesBuilt && m_halvesThreads == pool.size())
+        {
+            return;
+        }
+        const unsigned int nParticles {particleCount()};
+        m_counts.resize(nParticles);
+        m_halfCounts.resize(nParticles);
+        m_halfOffsets.resize(nParticles + 1u);
+        m_threadIndices.resize(pool.size());
+
+        pool.parallelFor(nParticles, [&](const unsigned int begin, const unsigned int end, const unsigned int thread)
+        {
+            // At most the full lists of the chunk: the owned pairs fill each list from its front, the cross ones from its back
+            std::vector<unsigned int>& indices {m_threadIndices[thread]};
+            indices.resize(m_offsets[end] - m_offsets[begin]);
+            unsigned int* list {indices.data()};
+            for(unsigned int i = begin; i < end; ++i)
+            {
+                unsigned int owned {0};
+                unsigned int cross {count(i)};
+                forEachNeighbor(i, [&](const unsigned int j)
+                {
+                    if(j >= begin && j < end)
+                    {
+                        list[owned] = j;
+                        owned += j > i ? 1u : 0u;
+                    }
+                    else
+                    {
+                        list[--cross] = j;
+                    }
+                });
+                // Pack the cross pairs right after the owned ones
+                std::copy(list + cross, list + count(i), list + owned);
+                m_halfCounts[i] = owned;
+                m_counts[i] = owned + count(i) - cross;
+                list += m_counts[i];
+            }
+            indices.resize(static_cast<std::size_t>(list - indices.data()));
+        });
+
+        m_halfOffsets[0] = 0u;
+        for(unsigned int i = 0; i < nParticles; ++i)
+        {
+            m_halfOffsets[i + 1u] = m_halfOffsets[i] + m_counts[i];
+        }
+        m_halfIndices.resize(m_halfOffsets[nParticles]);
+        pool.parallelFor(nParticles, [&](const unsigned int begin, const unsigned int, const unsigned int thread)
+        {
+            const std::vector<unsigned int>& indices {m_threadIndices[thread]};
+            std::copy(indices.begin(), indices.end(), m_halfIndices.begin() + m_halfOffsets[begin]);
+        });
+        m_halvesBuilt = true;
+        m_halvesThreads = pool.size();
+    }
+
+    // Takes back lists saved from offsets(), indices() and buildPositions() (e.g. by a checkpoint), as if they had just been built
+    // with radius
+    void restore(const unsigned int* offsets, const unsigned int nParticles, const unsigned int* indices, const float* x0, const float* y0,
+                 const float* z0, const float radius, const unsigned int rebuilds)
+    {
+        m_offsets.assign(offsets, offsets + nParticles + 1u);
+        m_indices.assign(indices, indices + m_offsets[nParticles]);
+        m_x0.assign(x0, x0 + nParticles);
+        m_y0.assign(y0, y0 + nParticles);
+        m_z0.assign(z0, z0 + nParticles);
+        m_radius = radius;
+        m_rebuilds = rebuilds;
+        m_halvesBuilt = false;
+    }
+
+    // Largest squared distance a particle has moved since the last build
+    float maxDisplacement2(const ParticleSoA& particles, ThreadPool& pool)
+    {
+        m_threadMax.assign(pool.size(), 0.0f);
+        pool.parallelFor(particles.size(), [&](const unsigned int begin, const unsigned int end, const unsigned int thread)
+        {
+            float maxDisplacement2 {0.0f};
+            for(unsigned int i = begin; i < end; ++i)
+            {
+                const float dx {particles.x[i] - m_x0[i]};
+                const float dy {particles.y[i] - m_y0[i]};
+                const float dz {particles.z[i] - m_z0[i]};
+                maxDisplacement2 = std::max(maxDisplacement2, dx * dx + dy * dy + dz * dz);
+            }
+            m_threadMax[thread] = maxDisplacement2;
+        });
+        return *std::max_element(m_threadMax.begin(), m_threadMax.end());
+    }
+
+    // Forgets the lists (the next step rebuilds them) and resets the counters
+    void clear()
+    {
+        m_offsets.clear();
+        m_indices.clear();
+        m_rebuilds = 0;
+        m_halvesBuilt = false;
+    }
+
+    // Calls fn(j) for every particle j in the list of i
+    template <typename F>
+    void forEachNeighbor(const unsigned int i, F&& fn) const
+    {
+        const unsigned int end {m_offsets[i + 1u]};
+        for(unsigned int k = m_offsets[i]; k < end; ++k)
+        {
+            fn(m_indices[k]);
+        }
+    }
+
+    // Position of the list of i in the index array, for per-entry data kept alongside it
+    unsigned int offset(const unsigned int i) const
+    {
+        return m_offsets[i];
+    }
+
+    const unsigned int* neighbors(const unsigned int i) const
+    {
+        return m_indices.data() + m_offsets[i];
+    }
+
+    unsigned int count(const unsigned int i) const
+    {
+        return m_offsets[i + 1u] - m_offsets[i];
+    }
+
+    // Half list of i, after buildHalves(): the halfCount(i) pairs it owns, then its crossCount(i) neighbors in other chunks
+    const unsigned int* halfNeighbors(const unsigned int i) const
+    {
+        return m_halfIndices.data() + m_halfOffsets[i];
+    }
+
+    unsigned int halfCount(const unsigned int i) const
+    {
+        return m_halfCounts[i];
+    }
+
+    unsigned int crossCount(const unsigned int i) const
+    {
+        return m_halfOffsets[i + 1u] - m_halfOffsets[i] - m_halfCounts[i];
+    }
+
+    // Number of particles the lists were built for
+    unsigned int particleCount() const
+    {
+        return m_offsets.empty() ? 0u : static_cast<unsigned int>(m_offsets.size() - 1u);
+    }
+
+    // Stored lists, for restore()
+    const std::vector<unsigned int>& offsets() const
+    {
+        return m_offsets;
+    }
+
+    const std::vector<unsigned int>& indices() const
+    {
+        return m_indices;
+    }
+
+    const FloatArray& buildPositions(const unsigned int axis) const
+    {
+        return axis == 0 ? m_x0 : axis == 1 ? m_y0 : m_z0;
+    }
+
+    // Radius of the last build
+    float radius() const
+    {
+        return m_radius;
+    }
+
+    // Counters
+    unsigned int rebuilds() const
+    {
+        return m_rebuilds;
+    }
+
+    std::size_t entries() const
+    {
+        return m_indices.size();
+    }
+
+    std::size_t memoryBytes() const
+    {
+        std::size_t bytes {(m_indices.capacity() + m_offsets.capacity() + m_counts.capacity() + m_halfIndices.capacity() + m_halfOffsets.capacity()
+                            + m_halfCounts.capacity()) * sizeof(unsigned int)};
+        bytes += (m_x0.capacity() + m_y0.capacity() + m_z0.capacity()) * sizeof(float);
+        for(const std::vector<unsigned int>& indices : m_threadIndices)
+        {
+            bytes += indices.capacity() * sizeof(unsigned int);
+        }
+        return bytes;
+    }
+
+private:
+    std::vector<unsigned int> m_offsets;
+    std::vector<unsigned int> m_indices;
+    std::vector<unsigned int> m_counts;
+    std::vector<std::vector<unsigned int>> m_threadIndices;
+    std::vector<float> m_threadMax;
+
+    // Half lists, current while m_halvesBuilt, for the chunks of a pool of m_halvesThreads
+    std::vector<unsigned int> m_halfOffsets;
+    std::vector<unsigned int> m_halfCounts;
+    std::vector<unsigned int> m_halfIndices;
+    bool m_halvesBuilt {false};
+    unsigned int m_halvesThreads {0};
+
+    // Positions at the last build
+    FloatArray m_x0;
+    FloatArray m_y0;
+    FloatArray m_z0;
+
+    float m_radius {0.0f};
+    unsigned int m_rebuilds {0};
+};
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+#endif // NEIGHBOR_LIST_HPP
@@ -3,15 +3,125 @@
 
 #include <HSGIL/math/vec3.hpp>
 
-struct Particle
+#include <new>
+#include <array>
+#include <vector>
+#include <cstddef>
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Aligned Allocator
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Every particle array starts on a cache line (and a full AVX-512 register), so vector loads never split lines
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+template <typename T, std::size_t Alignment = 64>
+struct AlignedAllocator
 {
-    gil::Vec3f v;
-    gil::Vec3f r;
-    gil::Vec3f f;
+    using value_type = T;
+
+    template <typename U>
+    struct rebind
+    {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+    T* allocate(const std::size_t n)
+    {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{Alignment}));
+    }
+
+    void deallocate(T* p, const std::size_t)
+    {
+        ::operator delete(p, std::align_val_t{Alignment});
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+};
+
+using FloatArray = std::vector<float, AlignedAllocator<float>>;
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Particle Storage (Structure of Arrays)
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Each attribute lives in its own array, so a pass only streams the fields it touches (the density pass reads x/y/z only)
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+struct ParticleSoA
+{
+    FloatArray x;
+    FloatArray y;
+    FloatArray z;
+
+    FloatArray vx;
+    FloatArray vy;
+    FloatArray vz;
+
+    FloatArray fx;
+    FloatArray fy;
+    FloatArray fz;
+
+    FloatArray density;
+    FloatArray pressure;
+    // Tint of the particle when rendered, 1 being the scene's particle color
+    FloatArray color;
+
+    unsigned int size() const
+    {
+        return static_cast<unsigned int>(x.size());
+    }
+
+    void resize(const unsigned int n)
+    {
+        for(FloatArray* a : arrays())
+        {
+            a->resize(n, 0.0f);
+        }
+    }
+
+    void add(const gil::Vec3f& r, const gil::Vec3f& v)
+    {
+        resize(size() + 1u);
+        setPosition(size() - 1u, r);
+        setVelocity(size() - 1u, v);
+        color[size() - 1u] = 1.0f;
+    }
+
+    gil::Vec3f position(const unsigned int i) const { return {x[i], y[i], z[i]}; }
+    gil::Vec3f velocity(const unsigned int i) const { return {vx[i], vy[i], vz[i]}; }
+    gil::Vec3f force(const unsigned int i)    const { return {fx[i], fy[i], fz[i]}; }
+
+    void setPosition(const unsigned int i, const gil::Vec3f& r) { x[i]  = r.x; y[i]  = r.y; z[i]  = r.z; }
+    void setVelocity(const unsigned int i, const gil::Vec3f& v) { vx[i] = v.x; vy[i] = v.y; vz[i] = v.z; }
+    void setForce(const unsigned int i, const gil::Vec3f& f)    { fx[i] = f.x; fy[i] = f.y; fz[i] = f.z; }
+
+    // Reorders every attribute so that particle k becomes the old particle permutation[k]
+    void permute(const std::vector<unsigned int>& permutation)
+    {
+        FloatArray scratch(permutation.size());
+        for(FloatArray* a : arrays())
+        {
+            for(unsigned int k = 0; k < permutation.size(); ++k)
+            {
+                scratch[k] = (*a)[permutation[k]];
+            }
+            a->swap(scratch);
+        }
+    }
 
-    float density;
-    float pressure;
-    float color;
+private:
+    std::array<FloatArray*, 12> arrays()
+    {
+        return {&x, &y, &z, &vx, &vy, &vz, &fx, &fy, &fz, &density, &pressure, &color};
+    }
 };
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
 
 #endif // PARTICLE_HPP
@@ -0,0 +1,179 @@
+#ifndef PARTICLE_STREAM_HPP
+#define PARTICLE_STREAM_HPP
+
+#include <HSGIL/external/glad/glad.h>
+
+#include <pipeline.hpp>
+#include <profiler.hpp>
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Particle Stream
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Streams the particles to the GPU every frame, with no vertex copy on the CPU side. The ring holds REGIONS regions, each one a
+// VBO with a packed vertex per particle (position and scalar color, 16 bytes): one per FrameExchange slot, plus a spare. The
+// slots the simulation thread may write are mapped, so its pool packs each snapshot straight into GPU-visible memory, and the
+// region travels through the exchange as the slot's buffer. A new frame unmaps the region it arrived in and draws and fences
+// it, and the slot handed back gets the spare region, mapped again once the GPU is done with it. By then the spare has waited
+// a frame or more, so the fence wait almost never blocks. GL 3.3 has no persistent mapping (glBufferStorage), and a buffer is
+// mapped at most once, hence one VBO per region, mapped and unmapped as it goes round.
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+class ParticleStream
+{
+public:
+    static constexpr unsigned int REGIONS {FrameExchange::SLOTS + 1u};
+    static constexpr unsigned int VERTEX_FLOATS {4};
+
+    // Creates the regions and gives the slots of frames theirs, before the simulation thread starts
+    void init(const unsigned int capacity, FrameExchange& frames)
+    {
+        static_assert(FrameSnapshot::VERTEX_FLOATS == VERTEX_FLOATS, "Snapshots must use the stream's vertex layout");
+        m_capacity = capacity;
+
+        glGenVertexArrays(REGIONS, m_VAOs);
+        glGenBuffers(REGIONS, m_VBOs);
+        for(unsigned int region = 0; region < REGIONS; ++region)
+        {
+            glBindVertexArray(m_VAOs[region]);
+
+            glBindBuffer(GL_ARRAY_BUFFER, m_VBOs[region]);
+            glBufferData(GL_ARRAY_BUFFER, regionBytes(), nullptr, GL_STREAM_DRAW);
+
+            // Position Attrib
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, VERTEX_FLOATS * sizeof(float), (void*)0);
+            glEnableVertexAttribArray(0);
+
+            // Particle Color
+            glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, VERTEX_FLOATS * sizeof(float), (void*)(3 * sizeof(float)));
+            glEnableVertexAttribArray(1);
+        }
+        glBindVertexArray(0);
+
+        // The consumer's slot is what draw() shows, nothing until the first snapshot arrives
+        for(unsigned int k = 0; k < FrameExchange::SLOTS; ++k)
+        {
+            FrameSnapshot& slot {frames.slot(k)};
+            slot.buffer = k;
+            slot.count = 0;
+            if(&slot != &frames.front())
+            {
+                mapRegion(slot);
+            }
+        }
+        m_region = frames.front().buffer;
+        m_count = 0;
+        m_spare = FrameExchange::SLOTS;
+    }
+
+    void destroy()
+    {
+        for(GLsync& fence : m_fences)
+        {
+            if(fence != nullptr)
+            {
+                glDeleteSync(fence);
+                fence = nullptr;
+            }
+        }
+        // Deleting the regions still mapped unmaps them
+        glDeleteVertexArrays(REGIONS, m_VAOs);
+        glDeleteBuffers(REGIONS, m_VBOs);
+    }
+
+    // Takes the newest snapshot of frames, if one arrived since the last call (returns false otherwise, and draw() shows the
+    // previous one again). Call it on the GL thread, while the simulation thread is running or after it stopped
+    bool update(FrameExchange& frames)
+    {
+        if(!frames.fresh())
+        {
+            return false;
+        }
+        SPH_PROFILE_ZONE(UPLOAD);
+
+        // The slot about to go back to the producer swaps its region, last drawn, for the spare one
+        FrameSnapshot& handedBack {frames.front()};
+        const unsigned int drawn {handedBack.buffer};
+        handedBack.buffer = m_spare;
+        mapRegion(handedBack);
+        m_spare = drawn;
+
+        frames.acquire();
+        const FrameSnapshot& snapshot {frames.front()};
+        m_region = snapshot.buffer;
+        glBindBuffer(GL_ARRAY_BUFFER, m_VBOs[m_region]);
+        // A mapping can lose its contents (e.g. on a display mode change), in which case the frame is skipped
+        const bool intact {glUnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE};
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        m_count = intact ? snapshot.count : 0u;
+        return true;
+    }
+
+    // Draws the region of the last snapshot taken by update() and fences it. Drawing it again without a new one moves its fence
+    void draw()
+    {
+        SPH_PROFILE_ZONE(RENDER);
+        glBindVertexArray(m_VAOs[m_region]);
+            glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(m_count));
+        glBindVertexArray(0);
+
+        if(m_fences[m_region] != nullptr)
+        {
+            glDeleteSync(m_fences[m_region]);
+        }
+        m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    // Number of regions that had to wait for the GPU before being mapped
+    unsigned int stalls() const
+    {
+        return m_stalls;
+    }
+
+private:
+    GLsizeiptr regionBytes() const
+    {
+        return static_cast<GLsizeiptr>(m_capacity) * VERTEX_FLOATS * sizeof(float);
+    }
+
+    // Maps the region of slot for the producer to write, once the GPU has finished reading it
+    void mapRegion(FrameSnapshot& slot)
+    {
+        waitRegion(slot.buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, m_VBOs[slot.buffer]);
+        const GLbitfield access {GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT};
+        slot.vertices = static_cast<float*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, regionBytes(), access));
+        slot.capacity = slot.vertices != nullptr ? m_capacity : 0u;
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void waitRegion(const unsigned int region)
+    {
+        GLsync& fence {m_fences[region]};
+        if(fence == nullptr)
+        {
+            return;
+        }
+        if(glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+        {
+            ++m_stalls;
+            while(glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED)
+            {
+            }
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    GLuint m_VAOs[REGIONS] {};
+    GLuint m_VBOs[REGIONS] {};
+    GLsync m_fences[REGIONS] {};
+
+    unsigned int m_capacity {0};
+    unsigned int m_count {0};
+    // Region drawn, and the one waiting for the GPU before it goes back to the producer
+    unsigned int m_region {0};
+    unsigned int m_spare {0};
+    unsigned int m_stalls {0};
+};
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+#endif // PARTICLE_STREAM_HPP
@@ -0,0 +1,145 @@
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+#include <atomic>
+#include <thread>
+
+#include <solver.hpp>
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Frame Snapshot
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// What the renderer needs from one simulation state: the particles packed as x, y, z, color (the ParticleStream vertex layout)
+// straight into the vertex buffer the renderer gave the slot, and where the solver was when it was taken
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+struct FrameSnapshot
+{
+    static constexpr unsigned int VERTEX_FLOATS {4};
+
+    // Set by the consumer: where to pack, with room for capacity particles (a mapped region of the ParticleStream ring), and
+    // which buffer that is. Without one, nothing is packed
+    float* vertices {nullptr};
+    unsigned int capacity {0};
+    unsigned int buffer {0};
+
+    // Particles packed
+    unsigned int count {0};
+    // Solver step the snapshot was taken after, and the steps run since the previous snapshot
+    unsigned int stepCount {0};
+    unsigned int substeps {0};
+};
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Frame Exchange
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Lock-free single-producer/single-consumer triple buffer. The producer fills its back slot and publishes it, the consumer
+// acquires the newest published slot; the third slot sits between them, so neither side ever waits for the other and
+// intermediate snapshots the consumer was too slow to see are simply overwritten. The consumer owns front() until its next
+// acquire(), so it may give that slot another buffer before handing it back.
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+class FrameExchange
+{
+public:
+    static constexpr unsigned int SLOTS {3};
+
+    // Before the producer starts, e.g. to give every slot its buffer
+    FrameSnapshot& slot(const unsigned int k)
+    {
+        return m_slots[k];
+    }
+
+    // Producer side
+    FrameSnapshot& back()
+    {
+        return m_slots[m_back];
+    }
+
+    void publish()
+    {
+        m_back = m_middle.exchange(m_back | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    // Consumer side. Whether a newer snapshot is waiting (only acquire() takes it, so it stays waiting until then)
+    bool fresh() const
+    {
+        return (m_middle.load(std::memory_order_relaxed) & FRESH) != 0u;
+    }
+
+    // Returns true when a newer snapshot replaced front()
+    bool acquire()
+    {
+        if(!fresh())
+        {
+            return false;
+        }
+        m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+
+    FrameSnapshot& front()
+    {
+        return m_slots[m_front];
+    }
+
+    const FrameSnapshot& front() const
+    {
+        return m_slots[m_front];
+    }
+
+private:
+    static constexpr unsigned int INDEX {3u};
+    static constexpr unsigned int FRESH {4u};
+
+    FrameSnapshot m_slots[SLOTS];
+    unsigned int m_back {0};
+    unsigned int m_front {1};
+    std::atomic<unsigned int> m_middle {2};
+};
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Simulation Thread
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Steps a simulation on its own thread (plus its pool) and publishes a snapshot after every batch of steps, so the solver is
+// not held back by vsync and the render thread never waits for a step. The state belongs to the thread between start() and
+// stop(): the renderer only reads frames().
+//
+// The steps follow the wall clock in simulated time: timeScale simulated seconds per wall-clock second (1 is real time,
+// whatever the timeStep of each step), running up to maxSubsteps steps before publishing when the solver falls behind, and
+// dropping the backlog beyond that. With timeScale = 0 it steps as fast as it can, publishing after every step.
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+class SimulationThread
+{
+public:
+    SimulationThread() = default;
+
+    SimulationThread(const SimulationThread&) = delete;
+    SimulationThread& operator=(const SimulationThread&) = delete;
+
+    ~SimulationThread()
+    {
+        stop();
+    }
+
+    void start(SPH_State& sim, double timeScale, unsigned int maxSubsteps);
+    void stop();
+
+    FrameExchange& frames()
+    {
+        return m_frames;
+    }
+
+private:
+    void run();
+    void takeSnapshot(FrameSnapshot& snapshot, unsigned int substeps);
+
+    SPH_State* m_sim {nullptr};
+    double m_timeScale {0.0};
+    unsigned int m_maxSubsteps {1};
+
+    FrameExchange m_frames;
+    std::thread m_thread;
+    std::atomic<bool> m_quit {false};
+};
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+#endif // PIPELINE_HPP
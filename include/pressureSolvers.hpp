@@ -0,0 +1,28 @@
+#ifndef PRESSURE_SOLVERS_HPP
+#define PRESSURE_SOLVERS_HPP
+
+#include <solver.hpp>
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pressure Solvers
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Incompressible alternatives to the state equation, dispatched by solvePressure(). Each one runs after the non-pressure forces
+// are in ps.fx/fy/fz and the timeStep is known, adds its pressure forces to them and fills sim.pressureStats.
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Precomputes what the solvers need from the parameters and sizes their scratch arrays (called by initSolver() and resumeSolver())
+void initPressureSolvers(SPH_State& sim);
+
+// Pair terms m ∇Wij (spiky gradient, r = ri - rj) of every neighbor list entry, zero outside the support, and the factors
+// αi = ρi / (|Σ m ∇Wij|² + Σ |m ∇Wij|²), capped at the one of a filled neighborhood. They stay valid for the whole step
+void computePairGradients(SPH_State& sim);
+
+// Velocity of the step v0 leads to from r0 over timeStep, once the boundary has acted on it. A prediction has to use it for the
+// particles pressed against a wall, or they are predicted to go through it and pile up there
+gil::Vec3f boundedVelocity(const SPH_State& sim, const gil::Vec3f& r0, const gil::Vec3f& v0);
+
+void solvePCISPH(SPH_State& sim);
+void solveDFSPH(SPH_State& sim);
+void solveIISPH(SPH_State& sim);
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+#endif // PRESSURE_SOLVERS_HPP
@@ -0,0 +1,181 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Profiler
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Scoped zones and counters on the hot path, compiled in with SPH_PROFILE only: otherwise SPH_PROFILE_ZONE() and
+// SPH_PROFILE_COUNT() expand to nothing. A zone reads the time stamp counter when entered and left and adds the difference to its
+// thread's accumulator, so it costs a few ns and never takes a lock. The totals of every thread are printed to stdout on exit.
+// With SPH_TRACE=<file> in the environment, the zones are also streamed as Chrome trace events (chrome://tracing, Perfetto),
+// written out in batches. Nothing per particle is timed, as the two counter reads would cost more than the work they measure
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+enum class ProfileZoneId : unsigned int
+{
+    STEP,
+    SORT,
+    GRID_BUILD,
+    NEIGHBOR_LIST,
+    DENSITY,
+    FORCES,
+    TIME_STEP,
+    PRESSURE,
+    INTEGRATE,
+    SNAPSHOT,
+    UPLOAD,
+    RENDER,
+    COUNT
+};
+
+enum class ProfileCounter : unsigned int
+{
+    // Distance tests of the density and force passes, pairs closer than supportRadius (i itself excluded), list rebuilds and
+    // boundary corrections (walls or ground hit by a particle, in the integration and the pressure solvers' predictions)
+    PAIR_TESTS,
+    SUPPORT_PAIRS,
+    NEIGHBOR_REBUILDS,
+    BOUNDARY_HITS,
+    COUNT
+};
+
+constexpr unsigned int PROFILE_ZONE_COUNT {static_cast<unsigned int>(ProfileZoneId::COUNT)};
+constexpr unsigned int PROFILE_COUNTER_COUNT {static_cast<unsigned int>(ProfileCounter::COUNT)};
+
+struct ProfileZoneInfo
+{
+    const char* name;
+    // Zones nested in another one are indented in the report
+    unsigned int depth;
+};
+
+constexpr ProfileZoneInfo PROFILE_ZONES[PROFILE_ZONE_COUNT]
+{
+    {"step",          0},
+    {"sort",          1},
+    {"grid build",    1},
+    {"neighbor list", 1},
+    {"density",       1},
+    {"forces",        1},
+    {"time step",     1},
+    {"pressure",      1},
+    {"integrate",     1},
+    {"snapshot",      0},
+    {"upload",        0},
+    {"render",        0}
+};
+
+constexpr const char* PROFILE_COUNTER_NAMES[PROFILE_COUNTER_COUNT] {"pair tests", "pairs within h", "neighbor-list rebuilds",
+                                                                   "boundary hits"};
+
+#ifdef SPH_PROFILE
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define SPH_PROFILE_TSC
+#else
+#include <chrono>
+#endif
+
+// Time stamp counter ticks (ns where there is none), converted to time by the report
+inline std::uint64_t profileTicks()
+{
+#ifdef SPH_PROFILE_TSC
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+struct ProfileEvent
+{
+    std::uint64_t begin;
+    std::uint64_t end;
+    ProfileZoneId zone;
+};
+
+// Events a thread keeps before writing them to the trace
+constexpr std::size_t PROFILE_TRACE_BATCH {4096};
+
+// Accumulators of one thread, written by that thread only. The profiler owns them, so they outlive the thread for the report
+struct ProfileThread
+{
+    unsigned int id;
+    bool tracing;
+    std::uint64_t ticks[PROFILE_ZONE_COUNT];
+    std::uint64_t calls[PROFILE_ZONE_COUNT];
+    std::uint64_t counters[PROFILE_COUNTER_COUNT];
+    std::vector<ProfileEvent> events;
+};
+
+ProfileThread* registerProfileThread();
+// Writes the events of a thread to the trace and clears them
+void flushProfileEvents(ProfileThread& thread);
+
+inline ProfileThread& profileThread()
+{
+    thread_local ProfileThread* const thread {registerProfileThread()};
+    return *thread;
+}
+
+class ProfileZone
+{
+public:
+    explicit ProfileZone(const ProfileZoneId zone)
+        : m_thread {profileThread()}, m_zone {zone}, m_begin {profileTicks()}
+    {
+    }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+    ~ProfileZone()
+    {
+        const std::uint64_t end {profileTicks()};
+        const unsigned int zone {static_cast<unsigned int>(m_zone)};
+        m_thread.ticks[zone] += end - m_begin;
+        ++m_thread.calls[zone];
+        if(m_thread.tracing)
+        {
+            m_thread.events.push_back({m_begin, end, m_zone});
+            if(m_thread.events.size() >= PROFILE_TRACE_BATCH)
+            {
+                flushProfileEvents(m_thread);
+            }
+        }
+    }
+
+private:
+    ProfileThread& m_thread;
+    const ProfileZoneId m_zone;
+    const std::uint64_t m_begin;
+};
+
+inline void profileCount(const ProfileCounter counter, const std::uint64_t n)
+{
+    profileThread().counters[static_cast<unsigned int>(counter)] += n;
+}
+
+#define SPH_PROFILE_CONCAT_(a, b) a##b
+#define SPH_PROFILE_CONCAT(a, b) SPH_PROFILE_CONCAT_(a, b)
+// Times the rest of the enclosing scope as zone (a ProfileZoneId)
+#define SPH_PROFILE_ZONE(zone) const ProfileZone SPH_PROFILE_CONCAT(profileZone, __LINE__) {ProfileZoneId::zone}
+// Adds n to counter (a ProfileCounter)
+#define SPH_PROFILE_COUNT(counter, n) profileCount(ProfileCounter::counter, n)
+
+#else
+
+#define SPH_PROFILE_ZONE(zone) static_cast<void>(0)
+#define SPH_PROFILE_COUNT(counter, n) static_cast<void>(0)
+
+#endif // SPH_PROFILE
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+#endif // PROFILER_HPP
@@ -0,0 +1,25 @@
+#ifndef REFERENCE_HPP
+#define REFERENCE_HPP
+
+#include <solver.hpp>
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Reference Solver
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// The brute-force passes of the first prototypes (blue-fluid.cpp for the standard force model, legacy.cpp for the legacy one):
+// every particle is tested against every other one, in index order, on one thread, with the kernels written out from their
+// formulas. O(N²) and slow, but with no grid, neighbor list, vector path, thread split or pair cache that could get something
+// wrong, so it is what those are checked against (tests/accuracy.cpp). Only the state equation is covered; the integrators and
+// boundaries, which only touch one particle at a time, are the solver's own.
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Densities and state equation pressures of all the particles
+void referenceDensityPressure(SPH_State& sim);
+
+// Forces of all the particles, and the extrema updateTimeStep() reads
+void referenceForces(SPH_State& sim);
+
+// stepSPH() with the reference passes, for a solver initialized with initSolver()
+void referenceStep(SPH_State& sim);
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+#endif // REFERENCE_HPP
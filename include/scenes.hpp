@@ -0,0 +1,44 @@
+#ifndef SCENES_HPP
+#define SCENES_HPP
+
+#include <string>
+#include <vector>
+
+#include <solver.hpp>
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Scenes
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Built-in scenes: "blue-fluid" (block drop in a box), "volcano" (eruption over a heightfield) and "legacy" (the first prototype)
+constexpr const char* SCENE_NAMES {"blue-fluid, volcano, legacy"};
+
+// Sets the parameters of a scene and spawns its particles, replacing any sim already had. name is a built-in scene or the path
+// of a scene file (see scenes/*.ini), and the overrides ("section.key=value", with the keys of the scene files, e.g.
+// "fluid.viscosity=2.5") are applied before the particles are spawned. Returns false with the reason in error if the scene
+// could not be loaded. The solver still has to be initialized afterwards, so callers can override parameters (e.g. nThreads)
+// in between
+bool loadScene(SPH_State& sim, const std::string& name, const std::vector<std::string>& overrides, std::string& error);
+
+// Boundaries by the names of the scene files ("box", "floor", "volcano"), nullptr for unknown ones
+BoundaryFn boundaryByName(const std::string& name);
+const char* boundaryName(BoundaryFn boundary);
+
+// Splits a command line: the "section.key=value" arguments go to overrides, the others are returned in order
+std::vector<std::string> sceneArguments(int argc, char* argv[], std::vector<std::string>& overrides);
+
+// Pressure solvers by name, for the command lines (the scenes use the state equation)
+constexpr const char* PRESSURE_SOLVER_NAMES {"state-equation, pcisph, dfsph, iisph"};
+
+// Selects a pressure solver after loadScene(), returns false if there is no such solver
+bool setPressureSolver(SPH_State& sim, const std::string& name);
+const char* pressureSolverName(PressureSolver solver);
+
+// Integrators by name: semi-implicit Euler, kick-drift-kick leapfrog and velocity Verlet (blue-fluid uses leapfrog, the others Euler)
+constexpr const char* INTEGRATOR_NAMES {"euler, leapfrog, verlet"};
+
+// Selects an integrator after loadScene(), returns false if there is no such integrator
+bool setIntegrator(SPH_State& sim, const std::string& name);
+const char* integratorName(Integrator integrator);
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+#endif // SCENES_HPP
@@ -0,0 +1,90 @@
+#ifndef SIMD_HPP
+#define SIMD_HPP
+
+#include <HSGIL/math/vec3.hpp>
+
+#include <kernels.hpp>
+#include <particle.hpp>
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Vectorized Pair Loops
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// The density and force sums of one particle over its neighbor list (NeighborList), 8 (AVX2) or 16 (AVX-512) candidates at
+// a time: their SoA fields are gathered into registers and the pairs outside the support are masked out. The instruction set
+// is picked at runtime from CPUID, so the same binary runs everywhere; the scalar path is used on other CPUs and compilers,
+// and gives the reference result the vector paths are compared against.
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+enum class SimdLevel
+{
+    SCALAR,
+    AVX2,
+    AVX512
+};
+
+// Widest instruction set supported by both the CPU and the build
+SimdLevel detectSimdLevel();
+
+const char* simdLevelName(SimdLevel level);
+
+// Per-particle sums of the standard force model
+struct ForceSums
+{
+    gil::Vec3f pressure;
+    gil::Vec3f viscosity;
+    gil::Vec3f surfaceNormal;
+    float colorLaplacian;
+};
+
+// Σ poly6(ri - rj) over the candidates inside the support, i itself included
+float densitySum(SimdLevel level, const ParticleSoA& ps, const SPHKernel& kernel, const gil::Vec3f& ri,
+                 const unsigned int* candidates, unsigned int nCandidates);
+
+// Same sum over positions kept outside the particles (e.g. the predicted positions of a pressure solver)
+float densitySum(SimdLevel level, const float* x, const float* y, const float* z, const SPHKernel& kernel, const gil::Vec3f& ri,
+                 const unsigned int* candidates, unsigned int nCandidates);
+
+// Pressure, viscosity and color field sums of particle i over the candidates inside the support, i itself excluded.
+// pressureTermi is pi / ρi²
+ForceSums standardForceSums(SimdLevel level, const ParticleSoA& ps, const SPHKernel& kernel, float mass, unsigned int i,
+                            float pressureTermi, const unsigned int* candidates, unsigned int nCandidates);
+
+// Floats per particle of the sums the symmetric pass scatters: the ten of ForceSums, in its order, padded to one 64-byte row
+constexpr unsigned int PAIR_STRIDE {16};
+
+// standardForceSums() over the nPairs first entries of a half list (NeighborList::buildHalves(), every j > i), which also adds the
+// same pairs, seen from j, to the row of each j in sums. The indices of one list are distinct, so a batch never writes the same
+// row twice
+ForceSums symmetricForceSums(SimdLevel level, const ParticleSoA& ps, const SPHKernel& kernel, float mass, unsigned int i, float pressureTermi,
+                             const unsigned int* neighbors, unsigned int nPairs, float* sums);
+
+// One particle's pairs inside the support, itself excluded, as the density pass caches them for the force pass (throughput mode):
+// neighbor index, direction (ri - rj) / |ri - rj| (0 for coincident particles) and distance, stored back to back from the first pair
+struct PairEntries
+{
+    unsigned int* neighbors;
+    float* directionX;
+    float* directionY;
+    float* directionZ;
+    float* distance;
+};
+
+// densitySum() of particle i over its candidates, which also writes its pairs to entries and returns their number in nPairs.
+// entries needs room for nCandidates pairs
+float densitySumCaching(SimdLevel level, const ParticleSoA& ps, const SPHKernel& kernel, unsigned int i, const unsigned int* candidates,
+                        unsigned int nCandidates, const PairEntries& entries, unsigned int& nPairs);
+
+// standardForceSums() over the pairs cached by densitySumCaching(): no position is gathered and no candidate tested
+ForceSums standardForceSumsCached(SimdLevel level, const ParticleSoA& ps, const SPHKernel& kernel, float mass, unsigned int i,
+                                  float pressureTermi, const PairEntries& entries, unsigned int nPairs);
+
+// Sums over a neighbor list with one precomputed pair term gk per entry (e.g. m ∇Wij), stored as arrays that start with the list.
+// Σ (vi - vj) · gk
+float pairDivergenceSum(SimdLevel level, const float* vx, const float* vy, const float* vz, const gil::Vec3f& vi, const float* gx,
+                        const float* gy, const float* gz, const unsigned int* neighbors, unsigned int nNeighbors);
+
+// Σ (termi + termj) gk
+gil::Vec3f pairGradientSum(SimdLevel level, const float* terms, float termi, const float* gx, const float* gy, const float* gz,
+                           const unsigned int* neighbors, unsigned int nNeighbors);
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+#endif // SIMD_HPP
@@ -0,0 +1,382 @@
+#ifndef SOLVER_HPP
+#define SOLVER_HPP
+
+#include <HSGIL/math/vec3.hpp>
+
+#include <vector>
+#include <cstddef>
+#include <initializer_list>
+
+#include <grid.hpp>
+#include <kernels.hpp>
+#include <neighborList.hpp>
+#include <simd.hpp>
+#include <particle.hpp>
+#include <threadPool.hpp>
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// SPH Solver (sph_core)
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Window-free simulation core shared by the demos and the headless runner. It only relies on the header-only parts of HSGIL
+// (Vec3f and the constants), so it builds and runs on machines without a display or GL driver.
+//
+// Typical use: fill the parameters (or load a scene), add particles, call initSolver() once and stepSPH() once per timeStep.
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+struct SPH_State;
+
+// Called for every particle after it has been advanced, to push it back inside the domain
+using BoundaryFn = void(*)(const SPH_State& sim, gil::Vec3f& r, gil::Vec3f& v);
+
+enum class ForceModel
+{
+    // Symmetric pressure term, gravity scaled by the rest density and surface tension (blue-fluid, volcano)
+    STANDARD,
+    // Averaged pressure term and gravity scaled by each particle's density, no surface tension (legacy)
+    LEGACY
+};
+
+enum class PressureSolver
+{
+    // Weakly compressible: p = gasStiffness * (ρ - ρ0), from the density of the step
+    STATE_EQUATION,
+    // Predictive-corrective incompressible SPH: the pressure is corrected until the predicted density error is below densityTolerance
+    PCISPH,
+    // Divergence-free SPH: a divergence-free velocity solve (down to divergenceTolerance), then a constant density solve, both
+    // warm-started from the previous step
+    DFSPH,
+    // Implicit incompressible SPH: the pressures solve the linearized constant density equation, by relaxed Jacobi iterations
+    // warm-started from the previous step
+    IISPH
+};
+
+enum class Integrator
+{
+    // v += dt a, then r += dt v
+    SEMI_IMPLICIT_EULER,
+    // Kick-drift-kick: half-step velocities, kicked by (dt_prev + dt) / 2 so that a varying timeStep stays symmetric
+    LEAPFROG,
+    // r += dt v + dt² a / 2, and v += dt (a_prev + a) / 2 once the new accelerations are known
+    VELOCITY_VERLET
+};
+
+// Stored as is by checkpoints: a new field also goes to storedParams() (src/checkpoint.cpp)
+struct SPH_Params
+{
+    float timeStep;
+    // With adaptiveTimeStep, timeStep is recomputed every step from the CFL conditions, scaled by cflFactor and clamped
+    bool adaptiveTimeStep;
+    float cflFactor;
+    float minTimeStep;
+    float maxTimeStep;
+
+    float restDensity;
+    float mass;
+    float viscosity;
+    float surfaceTension;
+    float threshold;
+    float gasStiffness;
+    float restitution;
+    float supportRadius;
+    float densityOffset;
+    ForceModel forceModel;
+    // The incompressible solvers replace the state equation of the standard model (the legacy model always uses the latter).
+    // They iterate until the average density error is below densityTolerance * restDensity, within [minIterations, maxIterations]
+    PressureSolver pressureSolver;
+    float densityTolerance;
+    // DFSPH only: bound on the average density change rate, as a fraction of restDensity per timeStep
+    float divergenceTolerance;
+    unsigned int minIterations;
+    unsigned int maxIterations;
+    // Visits every pair once and applies it to both particles (standard model only): half the pair work of the full pass, which
+    // pays off with the scalar kernels. The vectorized full pass gathers its neighbors cheaply enough that the scattered writes and
+    // the half lists (derived again after each list rebuild) cost more than the saved pairs, so it stays the faster one on AVX2
+    // and AVX-512
+    bool symmetricForces;
+    // Throughput mode for large, memory-bound scenes: the density pass keeps the pairs inside the support (neighbor index, direction
+    // and distance, 20 bytes per neighbor list entry) and the force pass reads them back instead of gathering positions and
+    // testing the whole list again. Ignored with symmetricForces
+    bool cachePairs;
+    // Time integration scheme of the state equation. The incompressible solvers predict with semi-implicit Euler, which they always use
+    Integrator integrator;
+
+    float damping;
+    float margin;
+    float boundaryWidth;
+    float boundaryHeight;
+    float boundaryDepth;
+    BoundaryFn boundary;
+
+    // Extra radius of the neighbor lists: they are rebuilt once a particle has moved skin / 2 (0 rebuilds them every step)
+    float skin;
+    // Particles are reordered along the Z-order curve at a list rebuild, at most every sortInterval steps (0 never)
+    unsigned int sortInterval;
+    unsigned int nThreads;
+};
+
+// Outcome of the pressure solve of the last step
+struct PressureSolveStats
+{
+    unsigned int iterations;
+    // Average (positive) density error of the last iteration, relative to restDensity
+    float densityError;
+    // Largest pressure acceleration, which the next timeStep has to account for (computeForces() does not see it)
+    float maxAcceleration;
+    // DFSPH divergence solve, its error relative to restDensity per timeStep
+    unsigned int divergenceIterations;
+    float divergenceError;
+};
+
+// Scratch arrays of the incompressible pressure solvers
+struct PressureSolverData
+{
+    // Predicted positions (PCISPH), or the steps the predicted velocities lead to once the boundary has acted, over timeStep
+    // (DFSPH, IISPH)
+    FloatArray x;
+    FloatArray y;
+    FloatArray z;
+    // Predicted velocities (DFSPH), advected velocities (IISPH)
+    FloatArray vx;
+    FloatArray vy;
+    FloatArray vz;
+    // Pressure accelerations (PCISPH, IISPH)
+    FloatArray ax;
+    FloatArray ay;
+    FloatArray az;
+    // Pair terms m ∇Wij, one per neighbor list entry (zero outside the support), computed once per step (DFSPH, IISPH)
+    FloatArray gradientX;
+    FloatArray gradientY;
+    FloatArray gradientZ;
+    // Per-particle terms of a pair gradient sum, e.g. κi / ρi
+    FloatArray terms;
+    // DFSPH factors, stiffness of the current iteration, and the stiffness of both solves summed over the step, which warm-starts
+    // the next one. IISPH keeps its pressures in kappa, for the same reason
+    FloatArray factor;
+    FloatArray kappaStep;
+    FloatArray kappa;
+    FloatArray kappaV;
+    // IISPH diagonal aii of the pressure system
+    FloatArray diagonal;
+    // Per-thread reductions
+    std::vector<double> threadSums;
+
+    // PCISPH pressure per unit of density error, times timeStep², and DFSPH factor, from a filled neighborhood
+    float pcisphScale;
+    float maxFactor;
+
+    // Keeps the warm-start state with its particles when they are reordered
+    void permute(const std::vector<unsigned int>& permutation)
+    {
+        for(FloatArray* a : {&kappa, &kappaV})
+        {
+            if(a->size() != permutation.size())
+            {
+                continue;
+            }
+            FloatArray scratch(permutation.size());
+            for(unsigned int k = 0; k < permutation.size(); ++k)
+            {
+                scratch[k] = (*a)[permutation[k]];
+            }
+            a->swap(scratch);
+        }
+    }
+};
+
+// Pairs kept by the density pass for the force pass (cachePairs), laid out like the neighbor lists: the pairs of i start at
+// sim.neighbors.offset(i), and counts[i] of them are used
+struct PairCache
+{
+    std::vector<unsigned int> neighbors;
+    FloatArray directionX;
+    FloatArray directionY;
+    FloatArray directionZ;
+    FloatArray distance;
+    std::vector<unsigned int> counts;
+
+    void resize(const std::size_t entries, const unsigned int nParticles)
+    {
+        neighbors.resize(entries);
+        directionX.resize(entries);
+        directionY.resize(entries);
+        directionZ.resize(entries);
+        distance.resize(entries);
+        counts.resize(nParticles);
+    }
+
+    PairEntries entries(const unsigned int offset)
+    {
+        return {neighbors.data() + offset, directionX.data() + offset, directionY.data() + offset, directionZ.data() + offset, distance.data() + offset};
+    }
+
+    std::size_t memoryBytes() const
+    {
+        return (neighbors.capacity() + counts.capacity()) * sizeof(unsigned int)
+             + (directionX.capacity() + directionY.capacity() + directionZ.capacity() + distance.capacity()) * sizeof(float);
+    }
+};
+
+// State the second-order integrators carry from one step to the next. With them, the particle velocities seen by the force pass
+// are predicted ones (v + dt a / 2 from the half-step velocities, v + dt a for velocity Verlet), corrected once the forces are known
+struct IntegratorData
+{
+    // Half-step velocities (LEAPFROG)
+    FloatArray vx;
+    FloatArray vy;
+    FloatArray vz;
+    // Accelerations of the previous step (VELOCITY_VERLET)
+    FloatArray ax;
+    FloatArray ay;
+    FloatArray az;
+    // Scheme the arrays belong to, and the timeStep of the previous step (0 until one was taken)
+    Integrator scheme;
+    float previousTimeStep;
+
+    void permute(const std::vector<unsigned int>& permutation)
+    {
+        for(FloatArray* a : {&vx, &vy, &vz, &ax, &ay, &az})
+        {
+            if(a->empty())
+            {
+                continue;
+            }
+            // Out of step with the particles: the next integration starts the scheme over
+            if(a->size() != permutation.size())
+            {
+                a->clear();
+                continue;
+            }
+            FloatArray scratch(permutation.size());
+            for(unsigned int k = 0; k < permutation.size(); ++k)
+            {
+                scratch[k] = (*a)[permutation[k]];
+            }
+            a->swap(scratch);
+        }
+    }
+};
+
+// Largest squared speed and acceleration seen by one thread during the force pass
+struct StepExtrema
+{
+    float speed2;
+    float acceleration2;
+};
+
+struct SPH_State : public SPH_Params
+{
+    ParticleSoA particles;
+    UniformGrid grid;
+    ThreadPool pool;
+    std::vector<unsigned int> permutation;
+    SPHKernel kernel;
+    // Instruction set of the density and standard force passes, detected by initSolver() (may be lowered afterwards)
+    SimdLevel simdLevel;
+    NeighborList neighbors;
+    // Force sums the symmetric pass scatters, PAIR_STRIDE floats per particle
+    FloatArray pairSums;
+
+    PressureSolverData pressureData;
+    PressureSolveStats pressureStats;
+    IntegratorData integratorData;
+    PairCache pairCache;
+
+    // Reduced by the force pass, as a by-product, for the timestep controller
+    std::vector<StepExtrema> extrema;
+    float maxSpeed;
+    float maxAcceleration;
+
+    unsigned int stepCount;
+    // Simulated time
+    double time;
+    // Reordering is due at the first neighbor list rebuild from this step on
+    unsigned int nextSort;
+};
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Boundaries
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Open-top box: the particles are reflected by the walls and the floor, but are free to splash above boundaryHeight
+void boxBoundary(const SPH_State& sim, gil::Vec3f& r, gil::Vec3f& v);
+
+// Infinite floor at y = 0
+void floorBoundary(const SPH_State& sim, gil::Vec3f& r, gil::Vec3f& v);
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Simulation
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Starts the worker threads, picks the SIMD level, builds the kernels for supportRadius and resets the step counter, once the parameters and the
+// particles are in place. Call it again after changing supportRadius or nThreads
+void initSolver(SPH_State& sim);
+
+// initSolver() for a state restored mid-run (restoreCheckpoint()): keeps the step counter, the simulated time, the neighbor lists and
+// what the integrator and the pressure solvers carry from one step to the next
+void resumeSolver(SPH_State& sim);
+
+// Advances the simulation by one timeStep (picked first, with adaptiveTimeStep). Returns true when the particles were reordered, in which case sim.permutation
+// holds the new order and any per-particle data kept outside the solver has to follow it
+bool stepSPH(SPH_State& sim);
+
+// Individual passes of stepSPH(), in order (updateTimeStep() only with adaptiveTimeStep), between which it counts the step and after
+// which it advances sim.time. updateNeighbors() rebuilds the neighbor lists when they are due, reordering the particles first when
+// a sort is due too (it then returns true, like stepSPH())
+bool updateNeighbors(SPH_State& sim);
+void computeDensityPressure(SPH_State& sim);
+void computeForces(SPH_State& sim);
+void updateTimeStep(SPH_State& sim);
+void solvePressure(SPH_State& sim);
+void integrate(SPH_State& sim);
+
+// The passes of stepSPH(), in order
+enum class StepPass
+{
+    NEIGHBORS,
+    DENSITY,
+    FORCES,
+    TIME_STEP,
+    PRESSURE,
+    INTEGRATE
+};
+
+constexpr unsigned int STEP_PASS_COUNT {6};
+
+// stepSPH() calling onPass(pass) as each pass returns (e.g. to time them), the one sequence of the passes stepSPH() runs too
+template <typename F>
+bool stepSPH(SPH_State& sim, F&& onPass)
+{
+    const bool reordered {updateNeighbors(sim)};
+    onPass(StepPass::NEIGHBORS);
+    ++sim.stepCount;
+
+    computeDensityPressure(sim);
+    onPass(StepPass::DENSITY);
+    computeForces(sim);
+    onPass(StepPass::FORCES);
+    if(sim.adaptiveTimeStep)
+    {
+        updateTimeStep(sim);
+        onPass(StepPass::TIME_STEP);
+    }
+    solvePressure(sim);
+    onPass(StepPass::PRESSURE);
+    integrate(sim);
+    onPass(StepPass::INTEGRATE);
+    sim.time += sim.timeStep;
+
+    return reordered;
+}
+
+// integrate() advances the particles with sim.integrator (semi-implicit Euler with an incompressible solver) and applies the boundary
+// in the same pass
+
+// updateTimeStep() picks the largest timeStep within [minTimeStep, maxTimeStep] that satisfies the velocity (cflFactor * h / vmax),
+// acceleration (cflFactor * sqrt(h / amax)) and viscous (0.125 h² / ν) conditions, from the extrema of the last force pass
+
+// True when the pressure comes from the state equation, in which case computeForces() includes it and solvePressure() does nothing.
+// Otherwise computeForces() only yields the non-pressure forces (and extrema), and solvePressure() adds the pressure forces for the
+// timeStep
+bool usesStateEquation(const SPH_State& sim);
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+#endif // SOLVER_HPP
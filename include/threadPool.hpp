@@ -0,0 +1,163 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+#include <condition_variable>
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Thread Pool
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Workers are created once and sleep between jobs, so a step never pays for thread creation. parallelFor() splits [0, n) into
+// one contiguous chunk per thread (the calling thread takes the first one): every index is processed by exactly one thread and
+// in the same order as the serial loop, so a pass that only writes its own particle gives the same bits for any thread count.
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+class ThreadPool
+{
+public:
+    ThreadPool() = default;
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool()
+    {
+        stop();
+    }
+
+    // Spawns nThreads - 1 workers; 0 means one thread per hardware core
+    void start(unsigned int nThreads)
+    {
+        stop();
+        if(nThreads == 0)
+        {
+            nThreads = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        m_quit = false;
+        m_nThreads = nThreads;
+        for(unsigned int t = 1; t < m_nThreads; ++t)
+        {
+            m_workers.emplace_back(&ThreadPool::workerLoop, this, t, m_generation);
+        }
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock {m_mutex};
+            m_quit = true;
+        }
+        m_wakeCondition.notify_all();
+        for(std::thread& worker : m_workers)
+        {
+            worker.join();
+        }
+        m_workers.clear();
+        m_nThreads = 1;
+    }
+
+    unsigned int size() const
+    {
+        return m_nThreads;
+    }
+
+    // Runs fn(begin, end, thread) over the chunks of [0, n) and returns once every chunk is done
+    template <typename F>
+    void parallelFor(const unsigned int n, F&& fn)
+    {
+        if(m_nThreads == 1 || n < m_nThreads)
+        {
+            fn(0u, n, 0u);
+            return;
+        }
+
+        using Fn = std::remove_reference_t<F>;
+        void* context {const_cast<void*>(static_cast<const void*>(&fn))};
+        {
+            std::lock_guard<std::mutex> lock {m_mutex};
+            m_job = &invoke<Fn>;
+            m_jobContext = context;
+            m_jobSize = n;
+            m_pending = m_nThreads - 1;
+            ++m_generation;
+        }
+        m_wakeCondition.notify_all();
+
+        runChunk(n, 0, &invoke<Fn>, context);
+
+        std::unique_lock<std::mutex> lock {m_mutex};
+        m_doneCondition.wait(lock, [this] { return m_pending == 0; });
+    }
+
+private:
+    using JobFn = void(*)(void*, unsigned int, unsigned int, unsigned int);
+
+    template <typename Fn>
+    static void invoke(void* context, const unsigned int begin, const unsigned int end, const unsigned int thread)
+    {
+        (*static_cast<Fn*>(context))(begin, end, thread);
+    }
+
+    void runChunk(const unsigned int n, const unsigned int thread, JobFn job, void* context) const
+    {
+        const unsigned long long begin {static_cast<unsigned long long>(n) * thread / m_nThreads};
+        const unsigned long long end {static_cast<unsigned long long>(n) * (thread + 1u) / m_nThreads};
+        job(context, static_cast<unsigned int>(begin), static_cast<unsigned int>(end), thread);
+    }
+
+    void workerLoop(const unsigned int thread, unsigned long long seenGeneration)
+    {
+        while(true)
+        {
+            JobFn job;
+            void* context;
+            unsigned int n;
+            {
+                std::unique_lock<std::mutex> lock {m_mutex};
+                m_wakeCondition.wait(lock, [&] { return m_quit || m_generation != seenGeneration; });
+                if(m_quit)
+                {
+                    return;
+                }
+                seenGeneration = m_generation;
+                job = m_job;
+                context = m_jobContext;
+                n = m_jobSize;
+            }
+
+            runChunk(n, thread, job, context);
+
+            bool last;
+            {
+                std::lock_guard<std::mutex> lock {m_mutex};
+                last = --m_pending == 0;
+            }
+            if(last)
+            {
+                m_doneCondition.notify_one();
+            }
+        }
+    }
+
+    unsigned int m_nThreads {1};
+    std::vector<std::thread> m_workers;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wakeCondition;
+    std::condition_variable m_doneCondition;
+
+    bool m_quit {false};
+    unsigned long long m_generation {0};
+    unsigned int m_pending {0};
+
+    JobFn m_job {nullptr};
+    void* m_jobContext {nullptr};
+    unsigned int m_jobSize {0};
+};
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+#endif // THREAD_POOL_HPP
@@ -1,7 +1,11 @@
 #include <HSGIL/hsgil.hpp>
-#include <particle.hpp>
+#include <scenes.hpp>
+#include <solver.hpp>
+#include <pipeline.hpp>
+#include <particleStream.hpp>
 
-#include <random>
+#include <vector>
+#include <string>
 #include <iostream>
 
 #define SCALE_FACTOR 10.0f
@@ -9,102 +13,13 @@
 // ---------------------------------------------------------------------------------------------------------------------------------------------------------------
 // SIM_Sate
 // ---------------------------------------------------------------------------------------------------------------------------------------------------------------
-struct SIM_State
+struct SIM_State : public SPH_State
 {
-    GLuint VAO;
-    GLuint VBO;
-    GLuint stride;
-    float* vertexData;
-
-    Particle* particles;
-    unsigned int nParticles;
-
-    float density;
-    float gasConstant;
-
-    float h;
-    float h2;
-
-    float mass;
-    float viscosity;
-
-    float damping;
-    float margin;
-    float boundaryWidth;
-    float boundaryHeight;
-    float boundaryDepth;
+    ParticleStream stream;
+    SimulationThread simulation;
 };
 // ---------------------------------------------------------------------------------------------------------------------------------------------------------------
 
-// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
-// Kernels
-// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
-float W(const float q, const float h)
-{
-    return (315.0f * q) / (65.0f * gil::constants::PI * pow(h, 9.0f));
-}
-
-float W1(const float q, const float h)
-{
-    return (-45.0f * q) / (gil::constants::PI * pow(h, 6.0f));
-}
-
-float W2(const float q, const float h)
-{
-    return (45.0f * q) / (gil::constants::PI * pow(h, 6.0f));
-}
-// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
-
-// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
-// Euler Solver
-// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
-void eulerIntegrate(const SIM_State& sim, const float step)
-{
-    for(unsigned int i = 0; i < sim.nParticles; ++i)
-    {
-        Particle& pi = sim.particles[i];
-
-        pi.v += step * pi.f / pi.density;
-        pi.r += step * pi.v;
-
-        /*
-        if(pi.r.x - sim.margin < 0.0f)
-        {
-            pi.v.x *= sim.damping;
-            pi.r.x = sim.margin;
-        }
-        if(pi.r.x + sim.margin > sim.boundaryWidth)
-        {
-            pi.v.x *= sim.damping;
-            pi.r.x = sim.boundaryWidth - sim.margin;
-        }
-        */
-        if(pi.r.y - sim.margin < 0.0f)
-        {
-            pi.v.y *= sim.damping;
-            pi.r.y = sim.margin;
-        }
-        /*
-        if(pi.r.y + sim.margin > sim.boundaryHeight)
-        {
-            pi.v.y *= sim.damping;
-            pi.r.y = sim.boundaryHeight - sim.margin;
-        }
-        if(pi.r.z - sim.margin < 0.0f)
-        {
-            pi.v.z *= sim.damping;
-            pi.r.z = sim.margin;
-        }
-        if(pi.r.z + sim.margin > sim.boundaryDepth)
-        {
-            pi.v.z *= sim.damping;
-            pi.r.z = sim.boundaryDepth - sim.margin;
-        }
-        */
-    }
-}
-// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
-
 // Init Functions
 // ---------------------------------------------------------------------------------------------------------------------------------------------------------------
 void initGLParams(const SIM_State& sim, const gil::RenderingWindow& window, gil::Shader& shader)
@@ -122,57 +37,19 @@ void initGLParams(const SIM_State& sim, const gil::RenderingWindow& window, gil:
     glm::mat4 projection = glm::perspective(45.0f, window.getAspectRatio(), 0.1f, 1000.0f);
     shader.setMat4("view", view);
     shader.setMat4("projection", projection);
+    shader.setFloat("boundaryDepth", sim.boundaryDepth);
     shader.setVec3("particleColor", {1.0f, 0.13f, 0.0f});
 }
 
 void initSPH(SIM_State& sim)
 {
-    sim.stride = 6;
-    sim.vertexData = new float[sim.stride * sim.nParticles];
-    sim.particles = new Particle[sim.nParticles];
+    sim.stream.init(sim.particles.size(), sim.simulation.frames());
 
-    gil::Vec3f pos;
-    unsigned int p {0};
-    for(pos.x = sim.boundaryWidth * 0.1f; pos.x < sim.boundaryWidth * 0.5f; pos.x += sim.h * 0.6f)
-	{
-		for (pos.y = sim.boundaryHeight * 0.1f; pos.y < sim.boundaryHeight * 0.5f; pos.y += sim.h * 0.6f)
-		{
-			for (pos.z = sim.boundaryDepth * 0.1f; pos.z < sim.boundaryDepth * 0.5f; pos.z += sim.h * 0.6f)
-			{
-				sim.particles[p].r = pos;
-                sim.particles[p].v = {0.0f, 32.0f, 0.0f};
-                sim.vertexData[p * 3 + 3] = 1.0f;
-                sim.vertexData[p * 3 + 4] = 0.13f;
-                sim.vertexData[p * 3 + 5] = 0.0f;
-                ++p;
-			}
-		}
-	}
-    sim.nParticles = p;
-
-    glGenVertexArrays(1, &sim.VAO);
-    glGenBuffers(1, &sim.VBO);
-
-    glBindVertexArray(sim.VAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, sim.VBO);
-    glBufferData(GL_ARRAY_BUFFER, 6 * sizeof(float) * sim.nParticles, sim.vertexData, GL_STATIC_DRAW);
-
-    // Position Attrib
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    // Particle Color
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-
-    glBindVertexArray(0);
-
-    std::cout << "Initialized with " << sim.nParticles << " particles" << std::endl;
+    std::cout << "Initialized with " << sim.particles.size() << " particles" << std::endl;
 }
 // ---------------------------------------------------------------------------------------------------------------------------------------------------------------
 
-int main()
+int main(int argc, char* argv[])
 {
     gil::RenderingWindow window {800, 600, "SPH"};
     if(!window.isReady())
@@ -184,23 +61,17 @@ int main()
     window.setInputHandler(inputHandler);
 
     SIM_State sim;
-    sim.nParticles = 100000;
-
-    sim.density = 1000.0f;
-    sim.gasConstant = 2000.0f;
-
-    sim.h = 16.0f;
-    sim.h2 = sim.h * sim.h;
-
-    sim.mass = 64.0f;
-    sim.viscosity = 250.0f;
-
-    sim.margin = sim.h;
-    sim.damping = -0.125f;
-    sim.boundaryWidth = 160.0f;
-    sim.boundaryHeight = 160.0f;
-    sim.boundaryDepth = 160.0f;
 
+    // Usage: legacy [scene file] [section.key=value ...]
+    std::vector<std::string> overrides;
+    const std::vector<std::string> args {sceneArguments(argc, argv, overrides)};
+    std::string error;
+    if(!loadScene(sim, args.size() > 0 ? args[0] : "legacy", overrides, error))
+    {
+        std::cerr << "Cannot load scene: " << error << std::endl;
+        return EXIT_FAILURE;
+    }
+    initSolver(sim);
     initSPH(sim);
 
     // ---------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -209,6 +80,9 @@ int main()
     gil::Shader shader("shader");
     initGLParams(sim, window, shader);
 
+    // Simulated time follows the wall clock, catching up with up to 8 steps per snapshot
+    sim.simulation.start(sim, 1.0, 8);
+
     while(window.isActive())
     {
         window.pollEvents();
@@ -219,90 +93,21 @@ int main()
         }
 
         // ---------------------------------------------------------------------------------------------------------------------------------------------------------------
-        // Compute Density-Pressure
-        // ---------------------------------------------------------------------------------------------------------------------------------------------------------------
-        for(unsigned int i = 0; i < sim.nParticles; ++i)
-        {
-            Particle& pi = sim.particles[i];
-
-            pi.density = 0;
-            for(unsigned int j = 0; j < sim.nParticles; ++j)
-            {
-                Particle& pj = sim.particles[j];
-                float r2 {gil::module(pj.r - pi.r) * gil::module(pj.r - pi.r)};
-
-                if(r2 < sim.h2)
-                {
-                    pi.density += sim.mass * W((sim.h2 - r2) * (sim.h2 - r2) * (sim.h2 - r2), sim.h);
-                }
-                // ^ This makes it better (I don't know why profe :'v) ...sim.mass * W(r, sim.h)... antigua version
-            }
-            pi.density += 8.0f;
-            pi.pressure = sim.gasConstant * (sim.particles[i].density - sim.density);
-            // ---------------------------------------------------------------------------------------------------------------------------------------------------------------
-        }
-
-        // ---------------------------------------------------------------------------------------------------------------------------------------------------------------
-        // Compute Forces
-        // ---------------------------------------------------------------------------------------------------------------------------------------------------------------
-        for(unsigned int i = 0; i < sim.nParticles; ++i)
-        {
-            Particle& pi = sim.particles[i];
-
-            gil::Vec3f fp {0.0f, 0.0f, 0.0f};
-            gil::Vec3f fv {0.0f, 0.0f, 0.0f};
-
-            for(unsigned int j = 0; j < sim.nParticles; ++j)
-            {
-                if(&pi == &sim.particles[j])
-                {
-                    continue;
-                }
-
-                Particle& pj = sim.particles[j];
-                float r {gil::module(pj.r - pi.r)};
-
-                if(r < sim.h)
-                {
-                    fp += -1.0f * gil::normalize(pj.r - pi.r) * sim.mass * (pi.pressure + pj.pressure) / (2.0f * pj.density) * W1((sim.h - r) * (sim.h - r), sim.h); // <- Lo mismo aqui
-                    fv += sim.viscosity * sim.mass * ((pj.v - pi.v) / pj.density) * W2(sim.h - r, sim.h);
-                }
-            }
-
-            gil::Vec3f g {0.0f, -gil::constants::GAL, 0.0f};
-            gil::Vec3f fg {g * pi.density};
-            pi.f = fp + fv + fg;
-        }
-        // ---------------------------------------------------------------------------------------------------------------------------------------------------------------
-
-        // ---------------------------------------------------------------------------------------------------------------------------------------------------------------
-        // Integrate by Euler 1th Order
+        // Simulation Step
         // ---------------------------------------------------------------------------------------------------------------------------------------------------------------
         timer.getDeltaTime();
-        eulerIntegrate(sim, 0.01f);
+        // Steps run on the simulation thread, which packs them straight into the stream; take its newest frame, if any
+        sim.stream.update(sim.simulation.frames());
         // ---------------------------------------------------------------------------------------------------------------------------------------------------------------
 
         // ---------------------------------------------------------------------------------------------------------------------------------------------------------------
         // Render
         // ---------------------------------------------------------------------------------------------------------------------------------------------------------------
-        shader.use();
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        glm::mat4 model;
-        for(unsigned int i = 0; i < sim.nParticles; ++i)
-        {
-            Particle& pi = sim.particles[i];
-
-            model = glm::mat4(1.0f);
-            model = glm::translate(model, glm::vec3{pi.r.x / SCALE_FACTOR, pi.r.y / SCALE_FACTOR, pi.r.z / SCALE_FACTOR});
-            float zColorDepth {pi.r.z / sim.boundaryDepth};
-            shader.setMat4("model", model);
-            shader.setVec3("colorDepth", {zColorDepth, zColorDepth, zColorDepth});
-
-            glBindVertexArray(sim.VAO);
-                glDrawArrays(GL_POINTS, 0, sim.nParticles);
-            glBindVertexArray(0);
-        }
+        shader.use();
+        shader.setMat4("model", glm::scale(glm::mat4(1.0f), glm::vec3{1.0f / SCALE_FACTOR}));
+        sim.stream.draw();
 
         window.swapBuffers();
         // ---------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -310,10 +115,8 @@ int main()
         timer.tick();
     }
 
-    glDeleteVertexArrays(1, &sim.VAO);
-    glDeleteBuffers(1, &sim.VBO);
+    sim.simulation.stop();
+    sim.stream.destroy();
 
-    delete[] sim.vertexData;
-    delete[] sim.particles;
     return 0;
 }
@@ -3,8 +3,6 @@ out vec4 FragColor;
 
 in vec3 color;
 
-uniform vec3 colorDepth;
-
 void main()
 {
     vec2 circCoord = 8.0f * gl_PointCoord - 1.0f;
@@ -18,6 +16,6 @@ void main()
     }
     else
     {
-        FragColor = vec4(colorDepth * color, 1.0f);
+        FragColor = vec4(color, 1.0f);
     }
 }
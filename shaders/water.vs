@@ -1,18 +1,22 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aColor;
+layout (location = 1) in float aColor;
 
 out vec3 color;
 
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
+uniform float boundaryDepth;
+uniform vec3 particleColor;
 
 #define pointSize 64.0f
 
 void main()
 {
-    color = aColor;
+    // Particles further back are drawn darker
+    float colorDepth = aPos.z / boundaryDepth;
+    color = colorDepth * aColor * particleColor;
     gl_Position = projection * view * model * vec4(aPos, 1.0f);
     gl_PointSize = pointSize;
 }
@@ -0,0 +1,547 @@
+#include <checkpoint.hpp>
+#include <scenes.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// File Layout
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+static constexpr char CHECKPOINT_MAGIC[8] {'S', 'P', 'H', 'C', 'K', 'P', 'T', '\0'};
+static constexpr std::size_t SECTION_ALIGNMENT {64};
+
+// What stepSPH() needs beyond the parameters and the arrays
+struct SolverState
+{
+    double time;
+    std::uint32_t stepCount;
+    std::uint32_t nextSort;
+    std::uint32_t neighborRebuilds;
+    Integrator integratorScheme;
+    float previousTimeStep;
+    float listRadius;
+    PressureSolveStats pressureStats;
+};
+
+static_assert(sizeof(CheckpointHeader) <= SECTION_ALIGNMENT, "the header has to fit before the section table");
+static_assert(std::is_trivially_copyable<SPH_Params>::value && std::is_trivially_copyable<SolverState>::value, "sections are raw copies");
+
+static std::size_t alignSection(const std::size_t offset)
+{
+    return (offset + SECTION_ALIGNMENT - 1u) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+}
+
+struct SectionSource
+{
+    CheckpointSection id;
+    const void* data;
+    std::uint32_t elementSize;
+    std::uint64_t count;
+};
+
+// The parameters of sim as stored: field by field over zeros, as a copy of the whole struct would also carry its padding bytes
+// (whatever was on the stack) into the file. The boundary function is stored by name, in the header
+static void storedParams(const SPH_Params& sim, SPH_Params& params)
+{
+    std::memset(&params, 0, sizeof(SPH_Params));
+    params.timeStep = sim.timeStep;
+    params.adaptiveTimeStep = sim.adaptiveTimeStep;
+    params.cflFactor = sim.cflFactor;
+    params.minTimeStep = sim.minTimeStep;
+    params.maxTimeStep = sim.maxTimeStep;
+    params.restDensity = sim.restDensity;
+    params.mass = sim.mass;
+    params.viscosity = sim.viscosity;
+    params.surfaceTension = sim.surfaceTension;
+    params.threshold = sim.threshold;
+    params.gasStiffness = sim.gasStiffness;
+    params.restitution = sim.restitution;
+    params.supportRadius = sim.supportRadius;
+    params.densityOffset = sim.densityOffset;
+    params.forceModel = sim.forceModel;
+    params.pressureSolver = sim.pressureSolver;
+    params.densityTolerance = sim.densityTolerance;
+    params.divergenceTolerance = sim.divergenceTolerance;
+    params.minIterations = sim.minIterations;
+    params.maxIterations = sim.maxIterations;
+    params.symmetricForces = sim.symmetricForces;
+    params.cachePairs = sim.cachePairs;
+    params.integrator = sim.integrator;
+    params.damping = sim.damping;
+    params.margin = sim.margin;
+    params.boundaryWidth = sim.boundaryWidth;
+    params.boundaryHeight = sim.boundaryHeight;
+    params.boundaryDepth = sim.boundaryDepth;
+    params.boundary = nullptr;
+    params.skin = sim.skin;
+    params.sortInterval = sim.sortInterval;
+    params.nThreads = sim.nThreads;
+}
+
+// Lays sim out as a checkpoint file in image
+static void buildImage(const SPH_State& sim, std::vector<unsigned char>& image)
+{
+    const ParticleSoA& ps {sim.particles};
+    const unsigned int nParticles {ps.size()};
+
+    SPH_Params params;
+    storedParams(sim, params);
+    SolverState state;
+    std::memset(&state, 0, sizeof(SolverState));
+    state.time = sim.time;
+    state.stepCount = sim.stepCount;
+    state.nextSort = sim.nextSort;
+    state.neighborRebuilds = sim.neighbors.rebuilds();
+    state.integratorScheme = sim.integratorData.scheme;
+    state.previousTimeStep = sim.integratorData.previousTimeStep;
+    state.listRadius = sim.neighbors.radius();
+    state.pressureStats = sim.pressureStats;
+
+    std::vector<SectionSource> sources
+    {
+        {CheckpointSection::PARAMETERS,   &params, sizeof(SPH_Params), 1u},
+        {CheckpointSection::SOLVER_STATE, &state,  sizeof(SolverState), 1u},
+        {CheckpointSection::X,        ps.x.data(),        sizeof(float), nParticles},
+        {CheckpointSection::Y,        ps.y.data(),        sizeof(float), nParticles},
+        {CheckpointSection::Z,        ps.z.data(),        sizeof(float), nParticles},
+        {CheckpointSection::VX,       ps.vx.data(),       sizeof(float), nParticles},
+        {CheckpointSection::VY,       ps.vy.data(),       sizeof(float), nParticles},
+        {CheckpointSection::VZ,       ps.vz.data(),       sizeof(float), nParticles},
+        {CheckpointSection::FX,       ps.fx.data(),       sizeof(float), nParticles},
+        {CheckpointSection::FY,       ps.fy.data(),       sizeof(float), nParticles},
+        {CheckpointSection::FZ,       ps.fz.data(),       sizeof(float), nParticles},
+        {CheckpointSection::DENSITY,  ps.density.data(),  sizeof(float), nParticles},
+        {CheckpointSection::PRESSURE, ps.pressure.data(), sizeof(float), nParticles},
+        {CheckpointSection::COLOR,    ps.color.data(),    sizeof(float), nParticles}
+    };
+    // Per-particle solver state only while it is in step with the particles
+    const auto addArray = [&](const CheckpointSection id, const FloatArray& a)
+    {
+        if(a.size() == nParticles && nParticles > 0u)
+        {
+            sources.push_back({id, a.data(), sizeof(float), nParticles});
+        }
+    };
+    addArray(CheckpointSection::HALF_STEP_VX, sim.integratorData.vx);
+    addArray(CheckpointSection::HALF_STEP_VY, sim.integratorData.vy);
+    addArray(CheckpointSection::HALF_STEP_VZ, sim.integratorData.vz);
+    addArray(CheckpointSection::PREVIOUS_AX, sim.integratorData.ax);
+    addArray(CheckpointSection::PREVIOUS_AY, sim.integratorData.ay);
+    addArray(CheckpointSection::PREVIOUS_AZ, sim.integratorData.az);
+    addArray(CheckpointSection::KAPPA, sim.pressureData.kappa);
+    addArray(CheckpointSection::KAPPA_V, sim.pressureData.kappaV);
+    if(sim.neighbors.particleCount() == nParticles && nParticles > 0u)
+    {
+        sources.push_back({CheckpointSection::LIST_OFFSETS, sim.neighbors.offsets().data(), sizeof(unsigned int), nParticles + 1u});
+        sources.push_back({CheckpointSection::LIST_INDICES, sim.neighbors.indices().data(), sizeof(unsigned int), sim.neighbors.entries()});
+        addArray(CheckpointSection::LIST_X0, sim.neighbors.buildPositions(0));
+        addArray(CheckpointSection::LIST_Y0, sim.neighbors.buildPositions(1));
+        addArray(CheckpointSection::LIST_Z0, sim.neighbors.buildPositions(2));
+    }
+
+    std::vector<CheckpointSectionEntry> table(sources.size());
+    std::size_t offset {alignSection(SECTION_ALIGNMENT + sources.size() * sizeof(CheckpointSectionEntry))};
+    for(std::size_t k = 0; k < sources.size(); ++k)
+    {
+        table[k] = {sources[k].id, sources[k].elementSize, offset, sources[k].count};
+        offset = alignSection(offset + sources[k].elementSize * sources[k].count);
+    }
+
+    CheckpointHeader header {};
+    std::memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    header.version = CHECKPOINT_VERSION;
+    header.parametersSize = sizeof(SPH_Params);
+    header.particleCount = nParticles;
+    header.sectionCount = static_cast<std::uint32_t>(sources.size());
+    header.fileSize = offset;
+    const char* boundary {boundaryName(sim.boundary)};
+    std::strncpy(header.boundary, boundary != nullptr ? boundary : "", sizeof(header.boundary) - 1u);
+
+    image.assign(offset, 0u);
+    std::memcpy(image.data(), &header, sizeof(header));
+    std::memcpy(image.data() + SECTION_ALIGNMENT, table.data(), table.size() * sizeof(CheckpointSectionEntry));
+    for(std::size_t k = 0; k < sources.size(); ++k)
+    {
+        if(sources[k].count > 0u)
+        {
+            std::memcpy(image.data() + table[k].offset, sources[k].data, sources[k].elementSize * sources[k].count);
+        }
+    }
+}
+
+// Writes image to path.tmp, then moves it over path
+static bool writeImage(const std::vector<unsigned char>& image, const std::string& path, std::string& error)
+{
+    const std::string temporary {path + ".tmp"};
+    {
+        std::ofstream file {temporary, std::ios::binary | std::ios::trunc};
+        file.write(reinterpret_cast<const char*>(image.data()), static_cast<std::streamsize>(image.size()));
+        if(!file.flush())
+        {
+            error = "cannot write '" + temporary + "'";
+            return false;
+        }
+    }
+#ifdef _WIN32
+    const bool moved {MoveFileExA(temporary.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0};
+#else
+    const bool moved {std::rename(temporary.c_str(), path.c_str()) == 0};
+#endif
+    if(!moved)
+    {
+        error = "cannot replace '" + path + "'";
+        return false;
+    }
+    return true;
+}
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Checkpoint File
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+bool CheckpointFile::open(const std::string& path, std::string& error)
+{
+    close();
+
+#ifdef _WIN32
+    m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    LARGE_INTEGER size;
+    if(m_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_file, &size))
+    {
+        m_file = nullptr;
+        error = "cannot open '" + path + "'";
+        return false;
+    }
+    m_size = static_cast<std::size_t>(size.QuadPart);
+    m_mapping = m_size > 0u ? CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+    m_data = m_mapping != nullptr ? static_cast<const unsigned char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+#else
+    const int file {::open(path.c_str(), O_RDONLY)};
+    struct stat status;
+    if(file < 0 || fstat(file, &status) != 0)
+    {
+        if(file >= 0)
+        {
+            ::close(file);
+        }
+        error = "cannot open '" + path + "'";
+        return false;
+    }
+    m_size = static_cast<std::size_t>(status.st_size);
+    void* data {m_size > 0u ? mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, file, 0) : MAP_FAILED};
+    // The mapping outlives the descriptor
+    ::close(file);
+    m_data = data != MAP_FAILED ? static_cast<const unsigned char*>(data) : nullptr;
+#endif
+
+    const auto fail = [&](const std::string& message)
+    {
+        close();
+        error = "'" + path + "' " + message;
+        return false;
+    };
+    if(m_data == nullptr)
+    {
+        return fail("cannot be mapped");
+    }
+    if(m_size < SECTION_ALIGNMENT || std::memcmp(header().magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0)
+    {
+        return fail("is not a checkpoint");
+    }
+    if(header().version != CHECKPOINT_VERSION || header().parametersSize != sizeof(SPH_Params))
+    {
+        return fail("was written by an incompatible build (version " + std::to_string(header().version) + ")");
+    }
+    if(header().fileSize != m_size || SECTION_ALIGNMENT + header().sectionCount * sizeof(CheckpointSectionEntry) > m_size)
+    {
+        return fail("is truncated");
+    }
+    const CheckpointSectionEntry* table {reinterpret_cast<const CheckpointSectionEntry*>(m_data + SECTION_ALIGNMENT)};
+    for(std::uint32_t k = 0; k < header().sectionCount; ++k)
+    {
+        // Divided rather than multiplied, so that no count can wrap the product around
+        const CheckpointSectionEntry& entry {table[k]};
+        if(entry.offset % SECTION_ALIGNMENT != 0u || entry.offset > m_size || entry.elementSize == 0u
+           || entry.count > (m_size - entry.offset) / entry.elementSize)
+        {
+            return fail("has a section out of bounds");
+        }
+    }
+    return true;
+}
+
+void CheckpointFile::close()
+{
+#ifdef _WIN32
+    if(m_data != nullptr)
+    {
+        UnmapViewOfFile(m_data);
+    }
+    if(m_mapping != nullptr)
+    {
+        CloseHandle(m_mapping);
+    }
+    if(m_file != nullptr)
+    {
+        CloseHandle(m_file);
+    }
+    m_mapping = nullptr;
+    m_file = nullptr;
+#else
+    if(m_data != nullptr)
+    {
+        munmap(const_cast<unsigned char*>(m_data), m_size);
+    }
+#endif
+    m_data = nullptr;
+    m_size = 0;
+}
+
+const void* CheckpointFile::section(const CheckpointSection id, const std::size_t elementSize, std::size_t& count) const
+{
+    const CheckpointSectionEntry* table {reinterpret_cast<const CheckpointSectionEntry*>(m_data + SECTION_ALIGNMENT)};
+    for(std::uint32_t k = 0; k < header().sectionCount; ++k)
+    {
+        if(table[k].id == id && table[k].elementSize == elementSize)
+        {
+            count = static_cast<std::size_t>(table[k].count);
+            return m_data + table[k].offset;
+        }
+    }
+    count = 0;
+    return nullptr;
+}
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Save and Restore
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+bool isCheckpointFile(const std::string& path)
+{
+    char magic[sizeof(CHECKPOINT_MAGIC)] {};
+    std::ifstream file {path, std::ios::binary};
+    return file.read(magic, sizeof(magic)) && std::memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) == 0;
+}
+
+bool writeCheckpoint(const SPH_State& sim, const std::string& path, std::string& error)
+{
+    std::vector<unsigned char> image;
+    buildImage(sim, image);
+    return writeImage(image, path, error);
+}
+
+// Whether saved lists can be walked: offsets starting at 0, never decreasing and ending at nIndices, and every index a particle
+static bool validLists(const unsigned int* offsets, const unsigned int nParticles, const unsigned int* indices, const std::size_t nIndices)
+{
+    if(offsets[0] != 0u || offsets[nParticles] != nIndices)
+    {
+        return false;
+    }
+    for(unsigned int i = 0; i < nParticles; ++i)
+    {
+        if(offsets[i + 1u] < offsets[i])
+        {
+            return false;
+        }
+    }
+    for(std::size_t k = 0; k < nIndices; ++k)
+    {
+        if(indices[k] >= nParticles)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool restoreCheckpoint(SPH_State& sim, const std::string& path, std::string& error)
+{
+    CheckpointFile file;
+    if(!file.open(path, error))
+    {
+        return false;
+    }
+
+    std::size_t nParams;
+    std::size_t nStates;
+    const SPH_Params* params {static_cast<const SPH_Params*>(file.section(CheckpointSection::PARAMETERS, sizeof(SPH_Params), nParams))};
+    const SolverState* state {static_cast<const SolverState*>(file.section(CheckpointSection::SOLVER_STATE, sizeof(SolverState), nStates))};
+    const BoundaryFn boundary {boundaryByName(file.header().boundary)};
+    if(params == nullptr || nParams != 1u || state == nullptr || nStates != 1u || boundary == nullptr)
+    {
+        error = "'" + path + "' lacks its parameters, its solver state or a known boundary";
+        return false;
+    }
+
+    // Copies a per-particle section into a, or empties a when the checkpoint has none
+    const unsigned int nParticles {file.header().particleCount};
+    const auto adopt = [&](const CheckpointSection id, FloatArray& a)
+    {
+        std::size_t count;
+        const float* data {static_cast<const float*>(file.section(id, sizeof(float), count))};
+        if(data != nullptr && count == nParticles)
+        {
+            a.assign(data, data + nParticles);
+            return true;
+        }
+        a.clear();
+        return false;
+    };
+
+    ParticleSoA& ps {sim.particles};
+    bool complete {true};
+    complete = adopt(CheckpointSection::X, ps.x) && complete;
+    complete = adopt(CheckpointSection::Y, ps.y) && complete;
+    complete = adopt(CheckpointSection::Z, ps.z) && complete;
+    complete = adopt(CheckpointSection::VX, ps.vx) && complete;
+    complete = adopt(CheckpointSection::VY, ps.vy) && complete;
+    complete = adopt(CheckpointSection::VZ, ps.vz) && complete;
+    complete = adopt(CheckpointSection::FX, ps.fx) && complete;
+    complete = adopt(CheckpointSection::FY, ps.fy) && complete;
+    complete = adopt(CheckpointSection::FZ, ps.fz) && complete;
+    complete = adopt(CheckpointSection::DENSITY, ps.density) && complete;
+    complete = adopt(CheckpointSection::PRESSURE, ps.pressure) && complete;
+    complete = adopt(CheckpointSection::COLOR, ps.color) && complete;
+    if(!complete && nParticles > 0u)
+    {
+        ps.resize(0);
+        error = "'" + path + "' lacks particle arrays";
+        return false;
+    }
+
+    static_cast<SPH_Params&>(sim) = *params;
+    sim.boundary = boundary;
+    sim.time = state->time;
+    sim.stepCount = state->stepCount;
+    sim.nextSort = state->nextSort;
+    sim.pressureStats = state->pressureStats;
+
+    IntegratorData& integratorData {sim.integratorData};
+    integratorData.scheme = state->integratorScheme;
+    integratorData.previousTimeStep = state->previousTimeStep;
+    adopt(CheckpointSection::HALF_STEP_VX, integratorData.vx);
+    adopt(CheckpointSection::HALF_STEP_VY, integratorData.vy);
+    adopt(CheckpointSection::HALF_STEP_VZ, integratorData.vz);
+    adopt(CheckpointSection::PREVIOUS_AX, integratorData.ax);
+    adopt(CheckpointSection::PREVIOUS_AY, integratorData.ay);
+    adopt(CheckpointSection::PREVIOUS_AZ, integratorData.az);
+    adopt(CheckpointSection::KAPPA, sim.pressureData.kappa);
+    adopt(CheckpointSection::KAPPA_V, sim.pressureData.kappaV);
+
+    // Without its lists, or with lists that do not fit the particles, the run rebuilds them at the next step (and may then reorder
+    // its particles earlier than the saved one)
+    std::size_t nOffsets;
+    std::size_t nIndices;
+    std::size_t nX0;
+    std::size_t nY0;
+    std::size_t nZ0;
+    const unsigned int* offsets {static_cast<const unsigned int*>(file.section(CheckpointSection::LIST_OFFSETS, sizeof(unsigned int), nOffsets))};
+    const unsigned int* indices {static_cast<const unsigned int*>(file.section(CheckpointSection::LIST_INDICES, sizeof(unsigned int), nIndices))};
+    const float* x0 {static_cast<const float*>(file.section(CheckpointSection::LIST_X0, sizeof(float), nX0))};
+    const float* y0 {static_cast<const float*>(file.section(CheckpointSection::LIST_Y0, sizeof(float), nY0))};
+    const float* z0 {static_cast<const float*>(file.section(CheckpointSection::LIST_Z0, sizeof(float), nZ0))};
+    if(offsets != nullptr && indices != nullptr && x0 != nullptr && y0 != nullptr && z0 != nullptr && nOffsets == nParticles + 1u
+       && nX0 == nParticles && nY0 == nParticles && nZ0 == nParticles && validLists(offsets, nParticles, indices, nIndices))
+    {
+        sim.neighbors.restore(offsets, nParticles, indices, x0, y0, z0, state->listRadius, state->neighborRebuilds);
+    }
+    else
+    {
+        sim.neighbors.clear();
+    }
+    return true;
+}
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Checkpoint Writer
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+void CheckpointWriter::start(const std::string& path, const unsigned int interval)
+{
+    stop();
+
+    m_path = path;
+    m_interval = interval;
+    m_quit = false;
+    m_thread = std::thread(&CheckpointWriter::run, this);
+}
+
+void CheckpointWriter::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock {m_mutex};
+        m_quit = true;
+    }
+    m_condition.notify_all();
+    if(m_thread.joinable())
+    {
+        m_thread.join();
+    }
+}
+
+bool CheckpointWriter::update(const SPH_State& sim)
+{
+    return m_interval != 0u && sim.stepCount % m_interval == 0u && save(sim);
+}
+
+bool CheckpointWriter::save(const SPH_State& sim)
+{
+    {
+        std::lock_guard<std::mutex> lock {m_mutex};
+        if(m_pending || !m_thread.joinable())
+        {
+            return false;
+        }
+    }
+    // Not pending: the image is ours until the thread is told about it
+    buildImage(sim, m_image);
+    {
+        std::lock_guard<std::mutex> lock {m_mutex};
+        m_pending = true;
+    }
+    m_condition.notify_one();
+    return true;
+}
+
+std::string CheckpointWriter::lastError()
+{
+    std::lock_guard<std::mutex> lock {m_mutex};
+    return m_error;
+}
+
+void CheckpointWriter::run()
+{
+    std::unique_lock<std::mutex> lock {m_mutex};
+    while(true)
+    {
+        m_condition.wait(lock, [this] { return m_pending || m_quit; });
+        if(!m_pending)
+        {
+            return;
+        }
+
+        lock.unlock();
+        std::string error;
+        const bool written {writeImage(m_image, m_path, error)};
+        lock.lock();
+
+        m_error = error;
+        if(written)
+        {
+            m_written.fetch_add(1u, std::memory_order_relaxed);
+        }
+        m_pending = false;
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,194 @@
+#include <pressureSolvers.hpp>
+
+#include <cmath>
+#include <algorithm>
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// DFSPH Passes
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Both solves work on velocities only, through the pair terms m ∇Wij of computePairGradients(), so every iteration is a plain
+// (vectorized) gather. A stiffness κi acts like pi / ρi: the correction vi -= dt Σ (κi / ρi + κj / ρj) m ∇Wij pushes i away from
+// its neighbors, and the factor αi turns a density error into the κi that cancels it
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Σ (vi - vj) · m ∇Wij, the rate at which the density of i changes under the velocities v
+static float densityChangeRate(const SPH_State& sim, const unsigned int i, const FloatArray& vx, const FloatArray& vy, const FloatArray& vz)
+{
+    const PressureSolverData& data {sim.pressureData};
+    const unsigned int offset {sim.neighbors.offset(i)};
+    return pairDivergenceSum(sim.simdLevel, vx.data(), vy.data(), vz.data(), {vx[i], vy[i], vz[i]}, data.gradientX.data() + offset,
+                             data.gradientY.data() + offset, data.gradientZ.data() + offset, sim.neighbors.neighbors(i), sim.neighbors.count(i));
+}
+
+// v -= dt Σ (κi / ρi + κj / ρj) m ∇Wij
+static void applyStiffness(SPH_State& sim, const FloatArray& kappa, FloatArray& vx, FloatArray& vy, FloatArray& vz)
+{
+    const ParticleSoA& ps = sim.particles;
+    PressureSolverData& data {sim.pressureData};
+    const float dt {sim.timeStep};
+
+    sim.pool.parallelFor(ps.size(), [&](const unsigned int begin, const unsigned int end, const unsigned int)
+    {
+        for(unsigned int i = begin; i < end; ++i)
+        {
+            data.terms[i] = kappa[i] / ps.density[i];
+        }
+    });
+    sim.pool.parallelFor(ps.size(), [&](const unsigned int begin, const unsigned int end, const unsigned int)
+    {
+        for(unsigned int i = begin; i < end; ++i)
+        {
+            const unsigned int offset {sim.neighbors.offset(i)};
+            const gil::Vec3f dv {pairGradientSum(sim.simdLevel, data.terms.data(), data.terms[i], data.gradientX.data() + offset, data.gradientY.data() + offset,
+                                                 data.gradientZ.data() + offset, sim.neighbors.neighbors(i), sim.neighbors.count(i))};
+            vx[i] -= dt * dv.x;
+            vy[i] -= dt * dv.y;
+            vz[i] -= dt * dv.z;
+        }
+    });
+}
+
+// Jacobi iterations of one solve. prepare() runs first in every iteration, then stiffness(i) returns the κi that cancels the error
+// of i under the velocities v, and adds its (positive) error to the thread's sum. kappa starts from the previous step's value,
+// halved, and accumulates the iterations
+template <typename P, typename F>
+static unsigned int solveStiffness(SPH_State& sim, const float tolerance, FloatArray& kappa, FloatArray& vx, FloatArray& vy, FloatArray& vz,
+                                   float& error, P&& prepare, F&& stiffness)
+{
+    PressureSolverData& data {sim.pressureData};
+    const unsigned int nParticles {sim.particles.size()};
+
+    for(float& k : kappa)
+    {
+        k *= 0.5f;
+    }
+    applyStiffness(sim, kappa, vx, vy, vz);
+
+    unsigned int iterations {0};
+    error = 0.0f;
+    while(iterations < sim.maxIterations)
+    {
+        prepare();
+        sim.pool.parallelFor(nParticles, [&](const unsigned int begin, const unsigned int end, const unsigned int thread)
+        {
+            double threadError {0.0};
+            for(unsigned int i = begin; i < end; ++i)
+            {
+                const float k {stiffness(i, threadError)};
+                data.kappaStep[i] = k;
+                kappa[i] += k;
+            }
+            data.threadSums[thread] = threadError;
+        });
+        applyStiffness(sim, data.kappaStep, vx, vy, vz);
+        ++iterations;
+
+        double sum {0.0};
+        for(const double threadSum : data.threadSums)
+        {
+            sum += threadSum;
+        }
+        error = nParticles == 0 ? 0.0f : static_cast<float>(sum / nParticles / sim.restDensity);
+        if(iterations >= sim.minIterations && error <= tolerance)
+        {
+            break;
+        }
+    }
+    return iterations;
+}
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// DFSPH
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// The divergence solve makes the current velocities divergence-free (only compression counts), then the non-pressure forces give
+// the predicted velocities, and the density solve corrects them until the density they lead to is within densityTolerance of
+// restDensity. The difference between the final and the current velocities becomes the pressure force, which the integration
+// applies
+void solveDFSPH(SPH_State& sim)
+{
+    ParticleSoA& ps = sim.particles;
+    PressureSolverData& data {sim.pressureData};
+    const unsigned int nParticles {ps.size()};
+    const float dt {sim.timeStep};
+
+    data.x.resize(nParticles);
+    data.y.resize(nParticles);
+    data.z.resize(nParticles);
+    data.vx.resize(nParticles);
+    data.vy.resize(nParticles);
+    data.vz.resize(nParticles);
+    data.factor.resize(nParticles);
+    data.terms.resize(nParticles);
+    data.kappaStep.resize(nParticles);
+    data.kappa.resize(nParticles, 0.0f);
+    data.kappaV.resize(nParticles, 0.0f);
+
+    computePairGradients(sim);
+
+    // Divergence-free solve, on the velocities themselves
+    sim.pressureStats = {};
+    sim.pressureStats.divergenceIterations = solveStiffness(sim, sim.divergenceTolerance, data.kappaV, ps.vx, ps.vy, ps.vz, sim.pressureStats.divergenceError,
+        []()
+    {
+    },
+        [&](const unsigned int i, double& error)
+    {
+        const float rate {std::max(0.0f, densityChangeRate(sim, i, ps.vx, ps.vy, ps.vz))};
+        error += rate * dt;
+        return rate / dt * data.factor[i];
+    });
+
+    // Constant density solve, on the predicted velocities
+    sim.pool.parallelFor(nParticles, [&](const unsigned int begin, const unsigned int end, const unsigned int)
+    {
+        for(unsigned int i = begin; i < end; ++i)
+        {
+            const float dtOverDensity {dt / ps.density[i]};
+            data.vx[i] = ps.vx[i] + dtOverDensity * ps.fx[i];
+            data.vy[i] = ps.vy[i] + dtOverDensity * ps.fy[i];
+            data.vz[i] = ps.vz[i] + dtOverDensity * ps.fz[i];
+        }
+    });
+    sim.pressureStats.iterations = solveStiffness(sim, sim.densityTolerance, data.kappa, data.vx, data.vy, data.vz, sim.pressureStats.densityError,
+        [&]()
+    {
+        sim.pool.parallelFor(nParticles, [&](const unsigned int begin, const unsigned int end, const unsigned int)
+        {
+            for(unsigned int i = begin; i < end; ++i)
+            {
+                const gil::Vec3f v {boundedVelocity(sim, ps.position(i), {data.vx[i], data.vy[i], data.vz[i]})};
+                data.x[i] = v.x;
+                data.y[i] = v.y;
+                data.z[i] = v.z;
+            }
+        });
+    },
+        [&](const unsigned int i, double& error)
+    {
+        const float densityError {std::max(0.0f, ps.density[i] + dt * densityChangeRate(sim, i, data.x, data.y, data.z) - sim.restDensity)};
+        error += densityError;
+        return densityError / (dt * dt) * data.factor[i];
+    });
+
+    // The integration divides the forces by the density
+    const float invDt {1.0f / dt};
+    sim.pool.parallelFor(nParticles, [&](const unsigned int begin, const unsigned int end, const unsigned int thread)
+    {
+        float acceleration2 {0.0f};
+        for(unsigned int i = begin; i < end; ++i)
+        {
+            const float dtOverDensity {dt / ps.density[i]};
+            const gil::Vec3f a {(data.vx[i] - ps.vx[i]) * invDt - ps.fx[i] / ps.density[i],
+                                (data.vy[i] - ps.vy[i]) * invDt - ps.fy[i] / ps.density[i],
+                                (data.vz[i] - ps.vz[i]) * invDt - ps.fz[i] / ps.density[i]};
+            ps.fx[i] = (data.vx[i] - ps.vx[i]) / dtOverDensity;
+            ps.fy[i] = (data.vy[i] - ps.vy[i]) / dtOverDensity;
+            ps.fz[i] = (data.vz[i] - ps.vz[i]) / dtOverDensity;
+            ps.pressure[i] = data.kappa[i] * ps.density[i];
+            acceleration2 = std::max(acceleration2, a.x * a.x + a.y * a.y + a.z * a.z);
+        }
+        data.threadSums[thread] = acceleration2;
+    });
+    sim.pressureStats.maxAcceleration = std::sqrt(static_cast<float>(*std::max_element(data.threadSums.begin(), data.threadSums.end())));
+}
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
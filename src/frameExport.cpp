@@ -0,0 +1,631 @@
+#include <frameExport.hpp>
+
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <utility>
+#include <algorithm>
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// File Layout
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+static constexpr char FILE_MAGIC[8] {'S', 'P', 'H', 'F', 'R', 'A', 'M', 'E'};
+static constexpr char CHUNK_MAGIC[4] {'F', 'R', 'M', '\0'};
+static constexpr char TRAILER_MAGIC[8] {'S', 'P', 'H', 'F', 'I', 'D', 'X', '\0'};
+
+// FrameFileHeader::flags
+static constexpr std::uint32_t FILE_QUANTIZED {1u};
+// FrameChunkHeader::flags and FrameIndexEntry::flags
+static constexpr std::uint32_t CHUNK_KEYFRAME {1u};
+static constexpr std::uint32_t CHUNK_UNCOMPRESSED {2u};
+
+static constexpr float QUANTIZED_MAX {65535.0f};
+// Margin a keyframe adds on both sides of a range, as a fraction of its width (or of its magnitude for a flat one), so that the
+// next frames fit in it
+static constexpr float RANGE_HEADROOM {0.25f};
+
+struct FrameFileTrailer
+{
+    std::uint64_t indexOffset;
+    std::uint32_t frameCount;
+    std::uint32_t reserved;
+    char magic[8];
+};
+
+static std::uint32_t zigzag(const std::uint32_t difference)
+{
+    const std::int16_t d {static_cast<std::int16_t>(difference)};
+    return static_cast<std::uint16_t>((d << 1) ^ (d >> 15));
+}
+
+static std::uint32_t unzigzag(const std::uint32_t z)
+{
+    return static_cast<std::uint16_t>((z >> 1) ^ (0u - (z & 1u)));
+}
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// LZ77 Block Coder
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// LZ4-like sequences: a token (literal count in the high nibble, match length - MIN_MATCH in the low one, 15 meaning that bytes
+// of 255 and a final smaller one follow), the literals, then a 2-byte match offset. The last sequence has literals only
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+static constexpr std::size_t MIN_MATCH {4};
+static constexpr std::size_t MAX_OFFSET {65535};
+static constexpr unsigned int HASH_BITS {16};
+
+static void putLength(std::vector<unsigned char>& out, std::size_t length)
+{
+    for(; length >= 255u; length -= 255u)
+    {
+        out.push_back(255u);
+    }
+    out.push_back(static_cast<unsigned char>(length));
+}
+
+static void putSequence(std::vector<unsigned char>& out, const unsigned char* literals, const std::size_t nLiterals, const std::size_t offset,
+                        const std::size_t matchLength)
+{
+    const std::size_t extraMatch {matchLength > 0u ? matchLength - MIN_MATCH : 0u};
+    out.push_back(static_cast<unsigned char>((std::min<std::size_t>(nLiterals, 15u) << 4) | std::min<std::size_t>(extraMatch, 15u)));
+    if(nLiterals >= 15u)
+    {
+        putLength(out, nLiterals - 15u);
+    }
+    out.insert(out.end(), literals, literals + nLiterals);
+    if(matchLength > 0u)
+    {
+        out.push_back(static_cast<unsigned char>(offset & 0xFFu));
+        out.push_back(static_cast<unsigned char>(offset >> 8));
+        if(extraMatch >= 15u)
+        {
+            putLength(out, extraMatch - 15u);
+        }
+    }
+}
+
+// table is scratch space, kept between calls
+static void compressLZ(const unsigned char* in, const std::size_t n, std::vector<unsigned char>& out, std::vector<std::uint32_t>& table)
+{
+    constexpr std::uint32_t EMPTY {~0u};
+    table.assign(std::size_t{1} << HASH_BITS, EMPTY);
+    out.clear();
+
+    std::size_t anchor {0};
+    std::size_t i {0};
+    while(i + MIN_MATCH <= n)
+    {
+        std::uint32_t sequence;
+        std::memcpy(&sequence, in + i, sizeof(sequence));
+        const std::uint32_t hash {(sequence * 2654435761u) >> (32u - HASH_BITS)};
+        const std::uint32_t candidate {table[hash]};
+        table[hash] = static_cast<std::uint32_t>(i);
+        if(candidate == EMPTY || i - candidate > MAX_OFFSET || std::memcmp(in + candidate, in + i, MIN_MATCH) != 0)
+        {
+            ++i;
+            continue;
+        }
+
+        std::size_t length {MIN_MATCH};
+        while(i + length < n && in[candidate + length] == in[i + length])
+        {
+            ++length;
+        }
+        putSequence(out, in + anchor, i - anchor, i - candidate, length);
+        i += length;
+        anchor = i;
+    }
+    putSequence(out, in + anchor, n - anchor, 0u, 0u);
+}
+
+static bool getLength(const unsigned char* in, const std::size_t n, std::size_t& pos, std::size_t& length)
+{
+    unsigned char byte;
+    do
+    {
+        if(pos >= n)
+        {
+            return false;
+        }
+        byte = in[pos++];
+        length += byte;
+    } while(byte == 255u);
+    return true;
+}
+
+// Fails on corrupted input rather than reading or writing out of bounds
+static bool decompressLZ(const unsigned char* in, const std::size_t n, unsigned char* out, const std::size_t outSize)
+{
+    std::size_t pos {0};
+    std::size_t written {0};
+    while(pos < n)
+    {
+        const unsigned char token {in[pos++]};
+        std::size_t nLiterals {static_cast<std::size_t>(token >> 4)};
+        if(nLiterals == 15u && !getLength(in, n, pos, nLiterals))
+        {
+            return false;
+        }
+        if(nLiterals > n - pos || nLiterals > outSize - written)
+        {
+            return false;
+        }
+        std::memcpy(out + written, in + pos, nLiterals);
+        pos += nLiterals;
+        written += nLiterals;
+        if(pos == n)
+        {
+            break;
+        }
+
+        if(n - pos < 2u)
+        {
+            return false;
+        }
+        const std::size_t offset {static_cast<std::size_t>(in[pos]) | static_cast<std::size_t>(in[pos + 1u]) << 8};
+        pos += 2u;
+        std::size_t length {static_cast<std::size_t>(token & 0x0Fu)};
+        if(length == 15u && !getLength(in, n, pos, length))
+        {
+            return false;
+        }
+        length += MIN_MATCH;
+        if(offset == 0u || offset > written || length > outSize - written)
+        {
+            return false;
+        }
+        // Byte by byte: the match may overlap what it is copying
+        for(std::size_t k = 0; k < length; ++k, ++written)
+        {
+            out[written] = out[written - offset];
+        }
+    }
+    return written == outSize;
+}
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Frame Writer
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+bool FrameWriter::open(const std::string& path, const bool quantize, const unsigned int keyframeInterval, std::string& error)
+{
+    close();
+
+    m_file.open(path, std::ios::binary | std::ios::trunc);
+    if(!m_file)
+    {
+        error = "cannot create '" + path + "'";
+        return false;
+    }
+
+    m_quantize = quantize;
+    m_keyframeInterval = std::max(1u, keyframeInterval);
+    FrameFileHeader header {};
+    std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+    header.version = FRAME_FILE_VERSION;
+    header.flags = quantize ? FILE_QUANTIZED : 0u;
+    header.keyframeInterval = m_keyframeInterval;
+    m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    m_ids.clear();
+    m_previousCount = 0;
+    m_index.clear();
+    m_offset = sizeof(header);
+    m_frames = 0;
+    m_rawBytes = 0;
+    m_writtenBytes = sizeof(header);
+    m_quit = false;
+    m_thread = std::thread(&FrameWriter::run, this);
+    return true;
+}
+
+void FrameWriter::close()
+{
+    if(!m_thread.joinable())
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock {m_mutex};
+        m_quit = true;
+    }
+    m_queued.notify_all();
+    m_thread.join();
+
+    FrameFileTrailer trailer {m_offset, static_cast<std::uint32_t>(m_index.size()), 0u, {}};
+    std::memcpy(trailer.magic, TRAILER_MAGIC, sizeof(TRAILER_MAGIC));
+    m_file.write(reinterpret_cast<const char*>(m_index.data()), static_cast<std::streamsize>(m_index.size() * sizeof(FrameIndexEntry)));
+    m_file.write(reinterpret_cast<const char*>(&trailer), sizeof(trailer));
+    m_file.close();
+    m_writtenBytes += m_index.size() * sizeof(FrameIndexEntry) + sizeof(trailer);
+}
+
+void FrameWriter::add(const SPH_State& sim)
+{
+    if(!m_thread.joinable())
+    {
+        return;
+    }
+
+    const ParticleSoA& ps {sim.particles};
+    const unsigned int nParticles {ps.size()};
+    // New particles get the next ids. Fewer particles than ids cannot be followed, so the ids start over
+    if(m_ids.size() > nParticles)
+    {
+        m_ids.clear();
+    }
+    const std::size_t nIds {m_ids.size()};
+    m_ids.resize(nParticles);
+    std::iota(m_ids.begin() + nIds, m_ids.end(), static_cast<unsigned int>(nIds));
+
+    ExportedFrame frame;
+    {
+        std::unique_lock<std::mutex> lock {m_mutex};
+        m_dequeued.wait(lock, [this] { return m_queue.size() < MAX_QUEUED; });
+        if(!m_free.empty())
+        {
+            frame = std::move(m_free.back());
+            m_free.pop_back();
+        }
+    }
+
+    frame.step = sim.stepCount;
+    frame.time = sim.time;
+    frame.count = nParticles;
+    frame.domain[0] = sim.boundaryWidth;
+    frame.domain[1] = sim.boundaryHeight;
+    frame.domain[2] = sim.boundaryDepth;
+    const FloatArray* sources[FRAME_FIELDS] {&ps.x, &ps.y, &ps.z, &ps.vx, &ps.vy, &ps.vz, &ps.density};
+    for(unsigned int f = 0; f < FRAME_FIELDS; ++f)
+    {
+        const FloatArray& source {*sources[f]};
+        std::vector<float>& field {frame.fields[f]};
+        field.resize(nParticles);
+        for(unsigned int i = 0; i < nParticles; ++i)
+        {
+            field[m_ids[i]] = source[i];
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock {m_mutex};
+        m_queue.push_back(std::move(frame));
+    }
+    m_queued.notify_one();
+}
+
+void FrameWriter::reorder(const std::vector<unsigned int>& permutation)
+{
+    if(permutation.size() != m_ids.size())
+    {
+        return;
+    }
+    std::vector<unsigned int> ids(permutation.size());
+    for(std::size_t k = 0; k < permutation.size(); ++k)
+    {
+        ids[k] = m_ids[permutation[k]];
+    }
+    m_ids.swap(ids);
+}
+
+unsigned int FrameWriter::frames()
+{
+    std::lock_guard<std::mutex> lock {m_mutex};
+    return m_frames;
+}
+
+std::uint64_t FrameWriter::rawBytes()
+{
+    std::lock_guard<std::mutex> lock {m_mutex};
+    return m_rawBytes;
+}
+
+std::uint64_t FrameWriter::writtenBytes()
+{
+    std::lock_guard<std::mutex> lock {m_mutex};
+    return m_writtenBytes;
+}
+
+void FrameWriter::run()
+{
+    std::vector<unsigned char> chunk;
+    std::unique_lock<std::mutex> lock {m_mutex};
+    while(true)
+    {
+        m_queued.wait(lock, [this] { return !m_queue.empty() || m_quit; });
+        if(m_queue.empty())
+        {
+            return;
+        }
+        ExportedFrame frame {std::move(m_queue.front())};
+        m_queue.pop_front();
+        lock.unlock();
+
+        encode(frame, chunk);
+        m_file.write(reinterpret_cast<const char*>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+        m_offset += chunk.size();
+
+        lock.lock();
+        ++m_frames;
+        m_rawBytes += static_cast<std::uint64_t>(frame.count) * FRAME_FIELDS * sizeof(float);
+        m_writtenBytes += chunk.size();
+        m_free.push_back(std::move(frame));
+        m_dequeued.notify_all();
+    }
+}
+
+void FrameWriter::encode(ExportedFrame& frame, std::vector<unsigned char>& chunk)
+{
+    const unsigned int n {frame.count};
+    const unsigned int frameIndex {static_cast<unsigned int>(m_index.size())};
+    const unsigned int width {m_quantize ? 2u : 4u};
+
+    // Extent of each field in this frame. A quantized frame that leaves the ranges of the last keyframe is a keyframe itself,
+    // which only widens the ranges it left (with headroom on the widened range, so a field that keeps growing soon fits); the
+    // scheduled keyframes fit the ranges to the frame again
+    float minimum[FRAME_FIELDS];
+    float maximum[FRAME_FIELDS];
+    bool grown[FRAME_FIELDS];
+    const bool scheduled {frameIndex % m_keyframeInterval == 0u || n != m_previousCount};
+    bool keyframe {scheduled};
+    for(unsigned int f = 0; f < FRAME_FIELDS; ++f)
+    {
+        const std::vector<float>& field {frame.fields[f]};
+        const auto range = std::minmax_element(field.begin(), field.end());
+        minimum[f] = n > 0u ? *range.first : 0.0f;
+        maximum[f] = n > 0u ? *range.second : 0.0f;
+        grown[f] = m_quantize && !scheduled && (minimum[f] < m_minimum[f] || maximum[f] > m_maximum[f]);
+        keyframe = keyframe || grown[f];
+    }
+    for(unsigned int f = 0; f < FRAME_FIELDS; ++f)
+    {
+        if(m_quantize && !scheduled && !grown[f])
+        {
+            continue;
+        }
+        const float low {grown[f] ? std::min(minimum[f], m_minimum[f]) : minimum[f]};
+        const float high {grown[f] ? std::max(maximum[f], m_maximum[f]) : maximum[f]};
+        const float headroom {m_quantize ? RANGE_HEADROOM * (high > low ? high - low : std::abs(high)) : 0.0f};
+        m_minimum[f] = low - headroom;
+        m_maximum[f] = high + headroom;
+        // Positions span the domain box, and get headroom only on the sides particles have left it by
+        if(m_quantize && f < 3u)
+        {
+            m_minimum[f] = low < 0.0f ? m_minimum[f] : 0.0f;
+            m_maximum[f] = high > frame.domain[f] ? m_maximum[f] : frame.domain[f];
+        }
+    }
+
+    FrameChunkHeader header {};
+    std::memcpy(header.magic, CHUNK_MAGIC, sizeof(CHUNK_MAGIC));
+    header.flags = keyframe ? CHUNK_KEYFRAME : 0u;
+    header.frame = frameIndex;
+    header.step = frame.step;
+    header.time = frame.time;
+    header.count = n;
+    header.rawSize = FRAME_FIELDS * n * width;
+
+    // Stored values, their changes since the previous frame, split into byte planes
+    std::vector<unsigned char>& raw {m_raw};
+    std::vector<std::uint32_t>& values {m_values};
+    raw.resize(header.rawSize);
+    for(unsigned int f = 0; f < FRAME_FIELDS; ++f)
+    {
+        const std::vector<float>& field {frame.fields[f]};
+        header.minimum[f] = m_minimum[f];
+        header.maximum[f] = m_maximum[f];
+        const float scale {header.maximum[f] > header.minimum[f] ? QUANTIZED_MAX / (header.maximum[f] - header.minimum[f]) : 0.0f};
+
+        values.resize(n);
+        std::vector<std::uint32_t>& previous {m_previous[f]};
+        for(unsigned int i = 0; i < n; ++i)
+        {
+            std::uint32_t value;
+            if(m_quantize)
+            {
+                value = static_cast<std::uint32_t>(std::lround(std::min(QUANTIZED_MAX, (field[i] - header.minimum[f]) * scale)));
+            }
+            else
+            {
+                std::memcpy(&value, &field[i], sizeof(value));
+            }
+            values[i] = value;
+            if(!keyframe)
+            {
+                value = m_quantize ? zigzag(value - previous[i]) : value ^ previous[i];
+            }
+            for(unsigned int b = 0; b < width; ++b)
+            {
+                raw[(static_cast<std::size_t>(f) * width + b) * n + i] = static_cast<unsigned char>(value >> (8u * b));
+            }
+        }
+        previous.swap(values);
+    }
+    m_previousCount = n;
+
+    compressLZ(raw.data(), raw.size(), m_packed, m_table);
+    const bool compressed {m_packed.size() < raw.size()};
+    const std::vector<unsigned char>& stored {compressed ? m_packed : raw};
+    header.flags |= compressed ? 0u : CHUNK_UNCOMPRESSED;
+    header.storedSize = static_cast<std::uint32_t>(stored.size());
+
+    chunk.resize(sizeof(header) + stored.size());
+    std::memcpy(chunk.data(), &header, sizeof(header));
+    std::memcpy(chunk.data() + sizeof(header), stored.data(), stored.size());
+    m_index.push_back({m_offset, frame.time, frame.step, header.flags});
+}
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Frame Reader
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+bool FrameReader::open(const std::string& path, std::string& error)
+{
+    m_file.close();
+    m_file.clear();
+    m_index.clear();
+    m_previousFrame = ~0u;
+
+    m_file.open(path, std::ios::binary);
+    FrameFileHeader header {};
+    if(!m_file.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0)
+    {
+        error = "'" + path + "' is not a frame file";
+        return false;
+    }
+    if(header.version != FRAME_FILE_VERSION)
+    {
+        error = "'" + path + "' has version " + std::to_string(header.version) + ", expected " + std::to_string(FRAME_FILE_VERSION);
+        return false;
+    }
+    m_quantize = (header.flags & FILE_QUANTIZED) != 0u;
+
+    m_file.seekg(0, std::ios::end);
+    const std::uint64_t size {static_cast<std::uint64_t>(m_file.tellg())};
+    FrameFileTrailer trailer {};
+    if(size >= sizeof(header) + sizeof(trailer))
+    {
+        m_file.seekg(static_cast<std::streamoff>(size - sizeof(trailer)));
+        m_file.read(reinterpret_cast<char*>(&trailer), sizeof(trailer));
+    }
+    if(m_file && std::memcmp(trailer.magic, TRAILER_MAGIC, sizeof(TRAILER_MAGIC)) == 0
+       && trailer.indexOffset + trailer.frameCount * sizeof(FrameIndexEntry) + sizeof(trailer) == size)
+    {
+        m_index.resize(trailer.frameCount);
+        m_file.seekg(static_cast<std::streamoff>(trailer.indexOffset));
+        if(m_file.read(reinterpret_cast<char*>(m_index.data()), static_cast<std::streamsize>(m_index.size() * sizeof(FrameIndexEntry))))
+        {
+            return true;
+        }
+        m_index.clear();
+    }
+
+    // No index (the writer did not get to close the file): walk the chunks, up to the first incomplete one
+    m_file.clear();
+    std::uint64_t offset {sizeof(header)};
+    FrameChunkHeader chunk;
+    while(offset + sizeof(chunk) <= size)
+    {
+        m_file.seekg(static_cast<std::streamoff>(offset));
+        if(!m_file.read(reinterpret_cast<char*>(&chunk), sizeof(chunk)) || std::memcmp(chunk.magic, CHUNK_MAGIC, sizeof(CHUNK_MAGIC)) != 0
+           || offset + sizeof(chunk) + chunk.storedSize > size)
+        {
+            break;
+        }
+        m_index.push_back({offset, chunk.time, chunk.step, chunk.flags});
+        offset += sizeof(chunk) + chunk.storedSize;
+    }
+    m_file.clear();
+    return true;
+}
+
+bool FrameReader::readChunk(const unsigned int k, FrameChunkHeader& header, std::vector<unsigned char>& raw, std::string& error)
+{
+    m_file.seekg(static_cast<std::streamoff>(m_index[k].offset));
+    if(!m_file.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::memcmp(header.magic, CHUNK_MAGIC, sizeof(CHUNK_MAGIC)) != 0
+       || header.rawSize != FRAME_FIELDS * header.count * (m_quantize ? 2u : 4u))
+    {
+        error = "frame " + std::to_string(k) + " has a bad header";
+        return false;
+    }
+
+    std::vector<unsigned char> stored(header.storedSize);
+    if(!m_file.read(reinterpret_cast<char*>(stored.data()), static_cast<std::streamsize>(stored.size())))
+    {
+        error = "frame " + std::to_string(k) + " is truncated";
+        return false;
+    }
+    if((header.flags & CHUNK_UNCOMPRESSED) != 0u)
+    {
+        raw.swap(stored);
+        return raw.size() == header.rawSize;
+    }
+    raw.resize(header.rawSize);
+    if(!decompressLZ(stored.data(), stored.size(), raw.data(), raw.size()))
+    {
+        error = "frame " + std::to_string(k) + " is corrupted";
+        return false;
+    }
+    return true;
+}
+
+bool FrameReader::read(const unsigned int k, ExportedFrame& frame, std::string& error)
+{
+    if(k >= m_index.size())
+    {
+        error = "no frame " + std::to_string(k);
+        return false;
+    }
+
+    unsigned int first {k};
+    while(first > 0u && (m_index[first].flags & CHUNK_KEYFRAME) == 0u)
+    {
+        --first;
+    }
+    if(m_previousFrame != ~0u && m_previousFrame >= first && m_previousFrame < k)
+    {
+        first = m_previousFrame + 1u;
+    }
+
+    const unsigned int width {m_quantize ? 2u : 4u};
+    FrameChunkHeader header;
+    std::vector<unsigned char> raw;
+    for(unsigned int j = first; j <= k; ++j)
+    {
+        m_previousFrame = ~0u;
+        if(!readChunk(j, header, raw, error))
+        {
+            return false;
+        }
+        const bool keyframe {(header.flags & CHUNK_KEYFRAME) != 0u};
+        const unsigned int n {header.count};
+        for(unsigned int f = 0; f < FRAME_FIELDS; ++f)
+        {
+            std::vector<std::uint32_t>& values {m_previous[f]};
+            if(!keyframe && values.size() != n)
+            {
+                error = "frame " + std::to_string(j) + " does not follow the frame before it";
+                return false;
+            }
+            values.resize(n);
+            for(unsigned int i = 0; i < n; ++i)
+            {
+                std::uint32_t value {0};
+                for(unsigned int b = 0; b < width; ++b)
+                {
+                    value |= static_cast<std::uint32_t>(raw[(static_cast<std::size_t>(f) * width + b) * n + i]) << (8u * b);
+                }
+                if(!keyframe)
+                {
+                    value = m_quantize ? static_cast<std::uint16_t>(values[i] + unzigzag(value)) : values[i] ^ value;
+                }
+                values[i] = value;
+            }
+        }
+        m_previousFrame = j;
+    }
+
+    frame.step = header.step;
+    frame.time = header.time;
+    frame.count = header.count;
+    for(unsigned int f = 0; f < FRAME_FIELDS; ++f)
+    {
+        const std::vector<std::uint32_t>& values {m_previous[f]};
+        std::vector<float>& field {frame.fields[f]};
+        field.resize(header.count);
+        const float step {(header.maximum[f] - header.minimum[f]) / QUANTIZED_MAX};
+        for(unsigned int i = 0; i < header.count; ++i)
+        {
+            if(m_quantize)
+            {
+                field[i] = header.minimum[f] + static_cast<float>(values[i]) * step;
+            }
+            else
+            {
+                std::memcpy(&field[i], &values[i], sizeof(float));
+            }
+        }
+    }
+    return true;
+}
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,173 @@
+#include <pressureSolvers.hpp>
+
+#include <cmath>
+#include <algorithm>
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// IISPH Passes
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// The pressure accelerations ai = -Σ (pi / ρi² + pj / ρj²) m ∇Wij change the density of i over one step by
+// (Ap)i = dt² Σ (ai - aj) · m ∇Wij, which is linear in the pressures. The system Ap = ρ0 - ρ_adv is never assembled: a product
+// is two gathers over the pair terms of computePairGradients(). Its diagonal is -dt² (|Σ m ∇Wij|² + Σ |m ∇Wij|²) / ρi², i.e.
+// -dt² / (ρi αi) with the DFSPH factor αi. The product is taken through the boundary (the advected velocities plus dt a go
+// through boundedVelocity()), so the pressure does not count on particles moving into a wall
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// a = -Σ (pi / ρi² + pj / ρj²) m ∇Wij, with data.terms holding p / ρ²
+static void pressureAccelerations(SPH_State& sim)
+{
+    PressureSolverData& data {sim.pressureData};
+
+    sim.pool.parallelFor(sim.particles.size(), [&](const unsigned int begin, const unsigned int end, const unsigned int)
+    {
+        for(unsigned int i = begin; i < end; ++i)
+        {
+            const unsigned int offset {sim.neighbors.offset(i)};
+            const gil::Vec3f a {pairGradientSum(sim.simdLevel, data.terms.data(), data.terms[i], data.gradientX.data() + offset, data.gradientY.data() + offset,
+                                                data.gradientZ.data() + offset, sim.neighbors.neighbors(i), sim.neighbors.count(i))};
+            data.ax[i] = -a.x;
+            data.ay[i] = -a.y;
+            data.az[i] = -a.z;
+        }
+    });
+}
+
+static void updatePressureTerms(SPH_State& sim)
+{
+    const ParticleSoA& ps = sim.particles;
+    PressureSolverData& data {sim.pressureData};
+
+    sim.pool.parallelFor(ps.size(), [&](const unsigned int begin, const unsigned int end, const unsigned int)
+    {
+        for(unsigned int i = begin; i < end; ++i)
+        {
+            data.terms[i] = data.kappa[i] / (ps.density[i] * ps.density[i]);
+        }
+    });
+}
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// IISPH
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// The non-pressure forces give the advected velocities, then the pressures follow from relaxed Jacobi iterations
+// pi += ω (ρ0 - ρ_adv - (Ap)i) / aii, clamped at 0 like the other solvers, until the average compression they leave is within
+// densityTolerance of restDensity. They start from half of the previous step's pressures, and their accelerations become the
+// pressure force
+void solveIISPH(SPH_State& sim)
+{
+    // Relaxation of the Jacobi updates (0.5 in the IISPH paper), halved whenever an iteration raises the error: heavily compressed
+    // neighborhoods (e.g. the volcano's spawn burst, at 7 ρ0) make plain Jacobi oscillate
+    float omega {0.5f};
+
+    ParticleSoA& ps = sim.particles;
+    PressureSolverData& data {sim.pressureData};
+    const unsigned int nParticles {ps.size()};
+    const float dt {sim.timeStep};
+    const float dt2 {dt * dt};
+
+    data.x.resize(nParticles);
+    data.y.resize(nParticles);
+    data.z.resize(nParticles);
+    data.vx.resize(nParticles);
+    data.vy.resize(nParticles);
+    data.vz.resize(nParticles);
+    data.ax.resize(nParticles);
+    data.ay.resize(nParticles);
+    data.az.resize(nParticles);
+    data.factor.resize(nParticles);
+    data.terms.resize(nParticles);
+    data.diagonal.resize(nParticles);
+    data.kappa.resize(nParticles, 0.0f);
+
+    computePairGradients(sim);
+
+    // Advected velocities, diagonal and warm start
+    sim.pool.parallelFor(nParticles, [&](const unsigned int begin, const unsigned int end, const unsigned int)
+    {
+        for(unsigned int i = begin; i < end; ++i)
+        {
+            const float dtOverDensity {dt / ps.density[i]};
+            data.vx[i] = ps.vx[i] + dtOverDensity * ps.fx[i];
+            data.vy[i] = ps.vy[i] + dtOverDensity * ps.fy[i];
+            data.vz[i] = ps.vz[i] + dtOverDensity * ps.fz[i];
+            data.diagonal[i] = data.factor[i] > 0.0f ? -dt2 / (ps.density[i] * data.factor[i]) : 0.0f;
+            data.kappa[i] = data.diagonal[i] < 0.0f ? 0.5f * data.kappa[i] : 0.0f;
+        }
+    });
+
+    sim.pressureStats = {};
+    unsigned int iterations {0};
+    while(iterations < sim.maxIterations)
+    {
+        updatePressureTerms(sim);
+        pressureAccelerations(sim);
+        // ρ_adv + (Ap)i = ρi + dt Σ (vi - vj) · m ∇Wij, over the velocities the pressures lead to
+        sim.pool.parallelFor(nParticles, [&](const unsigned int begin, const unsigned int end, const unsigned int)
+        {
+            for(unsigned int i = begin; i < end; ++i)
+            {
+                const gil::Vec3f v {boundedVelocity(sim, ps.position(i), {data.vx[i] + dt * data.ax[i], data.vy[i] + dt * data.ay[i], data.vz[i] + dt * data.az[i]})};
+                data.x[i] = v.x;
+                data.y[i] = v.y;
+                data.z[i] = v.z;
+            }
+        });
+
+        sim.pool.parallelFor(nParticles, [&](const unsigned int begin, const unsigned int end, const unsigned int thread)
+        {
+            double threadError {0.0};
+            for(unsigned int i = begin; i < end; ++i)
+            {
+                if(data.diagonal[i] == 0.0f)
+                {
+                    continue;
+                }
+                const unsigned int offset {sim.neighbors.offset(i)};
+                const float rate {pairDivergenceSum(sim.simdLevel, data.x.data(), data.y.data(), data.z.data(), {data.x[i], data.y[i], data.z[i]},
+                                                    data.gradientX.data() + offset, data.gradientY.data() + offset, data.gradientZ.data() + offset,
+                                                    sim.neighbors.neighbors(i), sim.neighbors.count(i))};
+                const float residual {sim.restDensity - ps.density[i] - dt * rate};
+                threadError += std::max(0.0f, -residual);
+                data.kappa[i] = std::max(0.0f, data.kappa[i] + omega * residual / data.diagonal[i]);
+            }
+            data.threadSums[thread] = threadError;
+        });
+        ++iterations;
+
+        double sum {0.0};
+        for(const double threadSum : data.threadSums)
+        {
+            sum += threadSum;
+        }
+        const float previousError {sim.pressureStats.densityError};
+        sim.pressureStats.densityError = nParticles == 0 ? 0.0f : static_cast<float>(sum / nParticles / sim.restDensity);
+        if(iterations > 1 && sim.pressureStats.densityError > previousError)
+        {
+            omega *= 0.5f;
+        }
+        if(iterations >= sim.minIterations && sim.pressureStats.densityError <= sim.densityTolerance)
+        {
+            break;
+        }
+    }
+    sim.pressureStats.iterations = iterations;
+
+    // Accelerations of the final pressures. The integration divides the forces by the density
+    updatePressureTerms(sim);
+    pressureAccelerations(sim);
+    sim.pool.parallelFor(nParticles, [&](const unsigned int begin, const unsigned int end, const unsigned int thread)
+    {
+        float acceleration2 {0.0f};
+        for(unsigned int i = begin; i < end; ++i)
+        {
+            ps.fx[i] += ps.density[i] * data.ax[i];
+            ps.fy[i] += ps.density[i] * data.ay[i];
+            ps.fz[i] += ps.density[i] * data.az[i];
+            ps.pressure[i] = data.kappa[i];
+            acceleration2 = std::max(acceleration2, data.ax[i] * data.ax[i] + data.ay[i] * data.ay[i] + data.az[i] * data.az[i]);
+        }
+        data.threadSums[thread] = acceleration2;
+    });
+    sim.pressureStats.maxAcceleration = std::sqrt(static_cast<float>(*std::max_element(data.threadSums.begin(), data.threadSums.end())));
+}
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
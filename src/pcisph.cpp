@@ -0,0 +1,126 @@
+#include <pressureSolvers.hpp>
+
+#include <cmath>
+#include <algorithm>
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// PCISPH
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Every iteration advances a copy of the particles by one timeStep under the current pressure, measures the density they would
+// reach and raises the pressure by pcisphScale / dt² per unit of compression, then recomputes the pressure accelerations
+// -m / ρ0² Σ (pi + pj) ∇Wp. The pressure is clamped at 0, so free surfaces are not pulled together, and only compression
+// counts as error
+void solvePCISPH(SPH_State& sim)
+{
+    ParticleSoA& ps = sim.particles;
+    PressureSolverData& data {sim.pressureData};
+    const SPHKernel& kernel {sim.kernel};
+    const unsigned int nParticles {ps.size()};
+    const float dt {sim.timeStep};
+    const float delta {data.pcisphScale / (dt * dt)};
+    const float pressureScale {sim.mass / (sim.restDensity * sim.restDensity)};
+
+    data.x.resize(nParticles);
+    data.y.resize(nParticles);
+    data.z.resize(nParticles);
+    data.ax.assign(nParticles, 0.0f);
+    data.ay.assign(nParticles, 0.0f);
+    data.az.assign(nParticles, 0.0f);
+    std::fill(ps.pressure.begin(), ps.pressure.end(), 0.0f);
+
+    sim.pressureStats = {};
+    for(unsigned int iteration = 0; iteration < sim.maxIterations; ++iteration)
+    {
+        // Predicted positions
+        sim.pool.parallelFor(nParticles, [&](const unsigned int begin, const unsigned int end, const unsigned int)
+        {
+            for(unsigned int i = begin; i < end; ++i)
+            {
+                const float invDensity {1.0f / ps.density[i]};
+                gil::Vec3f v {ps.vx[i] + dt * (ps.fx[i] * invDensity + data.ax[i]),
+                              ps.vy[i] + dt * (ps.fy[i] * invDensity + data.ay[i]),
+                              ps.vz[i] + dt * (ps.fz[i] * invDensity + data.az[i])};
+                gil::Vec3f r {ps.x[i] + dt * v.x, ps.y[i] + dt * v.y, ps.z[i] + dt * v.z};
+                sim.boundary(sim, r, v);
+
+                data.x[i] = r.x;
+                data.y[i] = r.y;
+                data.z[i] = r.z;
+            }
+        });
+
+        // Predicted densities and pressure correction
+        sim.pool.parallelFor(nParticles, [&](const unsigned int begin, const unsigned int end, const unsigned int thread)
+        {
+            double error {0.0};
+            for(unsigned int i = begin; i < end; ++i)
+            {
+                const gil::Vec3f ri {data.x[i], data.y[i], data.z[i]};
+                const float density {sim.mass * densitySum(sim.simdLevel, data.x.data(), data.y.data(), data.z.data(), kernel, ri,
+                                                           sim.neighbors.neighbors(i), sim.neighbors.count(i)) + sim.densityOffset};
+                const float densityError {density - sim.restDensity};
+                ps.pressure[i] = std::max(0.0f, ps.pressure[i] + delta * densityError);
+                error += std::max(0.0f, densityError);
+            }
+            data.threadSums[thread] = error;
+        });
+
+        // Pressure accelerations
+        sim.pool.parallelFor(nParticles, [&](const unsigned int begin, const unsigned int end, const unsigned int)
+        {
+            for(unsigned int i = begin; i < end; ++i)
+            {
+                const gil::Vec3f ri {ps.position(i)};
+                const float pressurei {ps.pressure[i]};
+                gil::Vec3f a {0.0f, 0.0f, 0.0f};
+
+                sim.neighbors.forEachNeighbor(i, [&](const unsigned int j)
+                {
+                    const gil::Vec3f r {ri.x - ps.x[j], ri.y - ps.y[j], ri.z - ps.z[j]};
+                    const float r2 {r.x * r.x + r.y * r.y + r.z * r.z};
+
+                    if(r2 < kernel.radius2())
+                    {
+                        // Zero for i itself
+                        const float s {-pressureScale * (pressurei + ps.pressure[j]) * kernel.spikyGradient(std::sqrt(r2))};
+                        a.x += s * r.x;
+                        a.y += s * r.y;
+                        a.z += s * r.z;
+                    }
+                });
+
+                data.ax[i] = a.x;
+                data.ay[i] = a.y;
+                data.az[i] = a.z;
+            }
+        });
+
+        double error {0.0};
+        for(const double threadSum : data.threadSums)
+        {
+            error += threadSum;
+        }
+        sim.pressureStats.iterations = iteration + 1u;
+        sim.pressureStats.densityError = nParticles == 0 ? 0.0f : static_cast<float>(error / nParticles / sim.restDensity);
+        if(sim.pressureStats.iterations >= sim.minIterations && sim.pressureStats.densityError <= sim.densityTolerance)
+        {
+            break;
+        }
+    }
+
+    // The integration divides the forces by the density
+    sim.pool.parallelFor(nParticles, [&](const unsigned int begin, const unsigned int end, const unsigned int thread)
+    {
+        float acceleration2 {0.0f};
+        for(unsigned int i = begin; i < end; ++i)
+        {
+            ps.fx[i] += ps.density[i] * data.ax[i];
+            ps.fy[i] += ps.density[i] * data.ay[i];
+            ps.fz[i] += ps.density[i] * data.az[i];
+            acceleration2 = std::max(acceleration2, data.ax[i] * data.ax[i] + data.ay[i] * data.ay[i] + data.az[i] * data.az[i]);
+        }
+        data.threadSums[thread] = acceleration2;
+    });
+    sim.pressureStats.maxAcceleration = std::sqrt(static_cast<float>(*std::max_element(data.threadSums.begin(), data.threadSums.end())));
+}
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,95 @@
+#include <pipeline.hpp>
+#include <profiler.hpp>
+
+#include <chrono>
+#include <algorithm>
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Simulation Thread
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+void SimulationThread::start(SPH_State& sim, const double timeScale, const unsigned int maxSubsteps)
+{
+    stop();
+
+    m_sim = &sim;
+    m_timeScale = timeScale;
+    m_maxSubsteps = std::max(1u, maxSubsteps);
+    m_quit.store(false, std::memory_order_relaxed);
+    m_thread = std::thread(&SimulationThread::run, this);
+}
+
+void SimulationThread::stop()
+{
+    m_quit.store(true, std::memory_order_release);
+    if(m_thread.joinable())
+    {
+        m_thread.join();
+    }
+}
+
+void SimulationThread::run()
+{
+    using Clock = std::chrono::steady_clock;
+
+    SPH_State& sim {*m_sim};
+    Clock::time_point last {Clock::now()};
+    double targetTime {sim.time};
+
+    while(!m_quit.load(std::memory_order_acquire))
+    {
+        unsigned int substeps {0};
+        if(m_timeScale <= 0.0)
+        {
+            stepSPH(sim);
+            substeps = 1;
+        }
+        else
+        {
+            const Clock::time_point now {Clock::now()};
+            targetTime += std::chrono::duration<double>(now - last).count() * m_timeScale;
+            last = now;
+
+            // The steps may change length (adaptive timeStep), so the clock is followed in simulated time rather than in steps
+            while(sim.time < targetTime && substeps < m_maxSubsteps)
+            {
+                stepSPH(sim);
+                ++substeps;
+            }
+            // Too far behind to catch up: let the simulation run slower than the clock rather than pile up work
+            targetTime = std::min(targetTime, sim.time + m_maxSubsteps * static_cast<double>(sim.timeStep));
+
+            if(substeps == 0)
+            {
+                std::this_thread::sleep_for(std::chrono::duration<double>((sim.time - targetTime) / m_timeScale));
+                continue;
+            }
+        }
+
+        takeSnapshot(m_frames.back(), substeps);
+        m_frames.publish();
+    }
+}
+
+void SimulationThread::takeSnapshot(FrameSnapshot& snapshot, const unsigned int substeps)
+{
+    SPH_PROFILE_ZONE(SNAPSHOT);
+    const ParticleSoA& ps {m_sim->particles};
+
+    snapshot.count = snapshot.vertices != nullptr ? std::min(ps.size(), snapshot.capacity) : 0u;
+    snapshot.stepCount = m_sim->stepCount;
+    snapshot.substeps = substeps;
+
+    float* vertices {snapshot.vertices};
+    m_sim->pool.parallelFor(snapshot.count, [&](const unsigned int begin, const unsigned int end, const unsigned int)
+    {
+        for(unsigned int i = begin; i < end; ++i)
+        {
+            float* vertex {vertices + i * FrameSnapshot::VERTEX_FLOATS};
+            vertex[0] = ps.x[i];
+            vertex[1] = ps.y[i];
+            vertex[2] = ps.z[i];
+            vertex[3] = ps.color[i];
+        }
+    });
+}
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,108 @@
+#include <pressureSolvers.hpp>
+
+#include <cmath>
+#include <algorithm>
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Setup
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// A uniform pressure p̃ on a filled neighborhood moves its particles so that the density changes by -β p̃ Σ ∇Wρ·∇Wp, with
+// β = 2 (dt m / ρ0)². The sum is taken once over a cubic lattice with the rest spacing (m / ρ0)^(1/3); only the dt² is left
+// for the step. The DFSPH factor of the same lattice bounds the factors of the particles, which grow without limit on sparse
+// neighborhoods (e.g. particles stacked by a boundary)
+void initPressureSolvers(SPH_State& sim)
+{
+    const SPHKernel& kernel {sim.kernel};
+    const float spacing {std::cbrt(sim.mass / sim.restDensity)};
+    const int extent {static_cast<int>(std::ceil(kernel.radius() / spacing))};
+
+    double gradientProducts {0.0};
+    double spikySquares {0.0};
+    for(int x = -extent; x <= extent; ++x)
+    {
+        for(int y = -extent; y <= extent; ++y)
+        {
+            for(int z = -extent; z <= extent; ++z)
+            {
+                const float r2 {spacing * spacing * static_cast<float>(x * x + y * y + z * z)};
+                if(r2 > 0.0f && r2 < kernel.radius2())
+                {
+                    const float spikyGradient {kernel.spikyGradient(std::sqrt(r2))};
+                    gradientProducts += kernel.poly6Gradient(r2) * spikyGradient * r2;
+                    spikySquares += spikyGradient * spikyGradient * r2;
+                }
+            }
+        }
+    }
+
+    PressureSolverData& data {sim.pressureData};
+    data.pcisphScale = gradientProducts > 0.0 ? static_cast<float>(sim.restDensity * sim.restDensity / (2.0 * sim.mass * sim.mass * gradientProducts)) : 0.0f;
+    data.maxFactor = spikySquares > 0.0 ? static_cast<float>(sim.restDensity / (sim.mass * sim.mass * spikySquares)) : 0.0f;
+    data.threadSums.assign(sim.pool.size(), 0.0);
+}
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Shared Passes
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+void computePairGradients(SPH_State& sim)
+{
+    const ParticleSoA& ps = sim.particles;
+    PressureSolverData& data {sim.pressureData};
+    const SPHKernel& kernel {sim.kernel};
+
+    const std::size_t nEntries {sim.neighbors.entries()};
+    data.gradientX.resize(nEntries);
+    data.gradientY.resize(nEntries);
+    data.gradientZ.resize(nEntries);
+
+    sim.pool.parallelFor(ps.size(), [&](const unsigned int begin, const unsigned int end, const unsigned int)
+    {
+        for(unsigned int i = begin; i < end; ++i)
+        {
+            const gil::Vec3f ri {ps.position(i)};
+            gil::Vec3f gradientSum {0.0f, 0.0f, 0.0f};
+            float squaredSum {0.0f};
+
+            unsigned int k {sim.neighbors.offset(i)};
+            sim.neighbors.forEachNeighbor(i, [&](const unsigned int j)
+            {
+                const gil::Vec3f r {ri.x - ps.x[j], ri.y - ps.y[j], ri.z - ps.z[j]};
+                const float r2 {r.x * r.x + r.y * r.y + r.z * r.z};
+
+                // Zero for i itself
+                const float s {r2 < kernel.radius2() ? sim.mass * kernel.spikyGradient(std::sqrt(r2)) : 0.0f};
+                data.gradientX[k] = s * r.x;
+                data.gradientY[k] = s * r.y;
+                data.gradientZ[k] = s * r.z;
+                ++k;
+
+                gradientSum.x += s * r.x;
+                gradientSum.y += s * r.y;
+                gradientSum.z += s * r.z;
+                squaredSum += s * s * r2;
+            });
+
+            const float denominator {gradientSum.x * gradientSum.x + gradientSum.y * gradientSum.y + gradientSum.z * gradientSum.z + squaredSum};
+            data.factor[i] = denominator > 1e-6f ? std::min(ps.density[i] / denominator, data.maxFactor) : 0.0f;
+        }
+    });
+}
+
+gil::Vec3f boundedVelocity(const SPH_State& sim, const gil::Vec3f& r0, const gil::Vec3f& v0)
+{
+    const float dt {sim.timeStep};
+    gil::Vec3f v {v0};
+    gil::Vec3f r {r0.x + dt * v.x, r0.y + dt * v.y, r0.z + dt * v.z};
+    sim.boundary(sim, r, v);
+
+    // A boundary that moves the particle further than its own step relocates it (e.g. onto a heightfield) rather than stopping
+    // it, and is left out
+    const gil::Vec3f step {(r.x - r0.x) / dt, (r.y - r0.y) / dt, (r.z - r0.z) / dt};
+    if(step.x * step.x + step.y * step.y + step.z * step.z <= v0.x * v0.x + v0.y * v0.y + v0.z * v0.z)
+    {
+        return step;
+    }
+    return v0;
+}
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,189 @@
+#include <profiler.hpp>
+
+#ifdef SPH_PROFILE
+
+#include <mutex>
+#include <memory>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Profiler
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Created by the first zone or counter, destroyed on exit, once every thread that used it has been joined
+class Profiler
+{
+public:
+    Profiler()
+    {
+        using Clock = std::chrono::steady_clock;
+        const Clock::time_point start {Clock::now()};
+        m_start = profileTicks();
+#ifdef SPH_PROFILE_TSC
+        // Counter rate against the steady clock, over a few ms
+        while(Clock::now() - start < std::chrono::milliseconds(5))
+        {
+        }
+        const double ns {std::chrono::duration<double, std::nano>(Clock::now() - start).count()};
+        m_nsPerTick = ns / static_cast<double>(profileTicks() - m_start);
+#else
+        static_cast<void>(start);
+#endif
+
+        const char* const tracePath {std::getenv("SPH_TRACE")};
+        if(tracePath != nullptr && *tracePath != '\0')
+        {
+            m_tracePath = tracePath;
+            m_trace.open(m_tracePath, std::ios::trunc);
+            if(m_trace)
+            {
+                m_trace << "{\"traceEvents\":[";
+            }
+            else
+            {
+                std::cerr << "Cannot write the trace to '" << m_tracePath << "'" << std::endl;
+            }
+        }
+    }
+
+    ~Profiler()
+    {
+        for(const std::unique_ptr<ProfileThread>& thread : m_threads)
+        {
+            flush(*thread);
+        }
+        if(m_trace)
+        {
+            m_trace << "\n]}\n";
+            m_trace.close();
+        }
+        report(std::cout);
+    }
+
+    ProfileThread* add()
+    {
+        std::lock_guard<std::mutex> lock {m_mutex};
+        m_threads.push_back(std::make_unique<ProfileThread>());
+        ProfileThread& thread {*m_threads.back()};
+        thread.id = static_cast<unsigned int>(m_threads.size() - 1u);
+        thread.tracing = static_cast<bool>(m_trace);
+        if(thread.tracing)
+        {
+            thread.events.reserve(PROFILE_TRACE_BATCH);
+        }
+        return &thread;
+    }
+
+    void flush(ProfileThread& thread)
+    {
+        std::lock_guard<std::mutex> lock {m_mutex};
+        for(const ProfileEvent& event : thread.events)
+        {
+            m_trace << (m_events++ == 0u ? "\n" : ",\n") << "{\"name\":\"" << PROFILE_ZONES[static_cast<unsigned int>(event.zone)].name
+                    << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread.id << std::fixed << std::setprecision(3)
+                    << ",\"ts\":" << microseconds(event.begin - m_start) << ",\"dur\":" << microseconds(event.end - event.begin) << "}";
+        }
+        thread.events.clear();
+    }
+
+private:
+    double microseconds(const std::uint64_t ticks) const
+    {
+        return static_cast<double>(ticks) * m_nsPerTick * 1e-3;
+    }
+
+    void report(std::ostream& out) const
+    {
+        std::uint64_t ticks[PROFILE_ZONE_COUNT] {};
+        std::uint64_t calls[PROFILE_ZONE_COUNT] {};
+        unsigned int threads[PROFILE_ZONE_COUNT] {};
+        std::uint64_t counters[PROFILE_COUNTER_COUNT] {};
+        for(const std::unique_ptr<ProfileThread>& thread : m_threads)
+        {
+            for(unsigned int zone = 0; zone < PROFILE_ZONE_COUNT; ++zone)
+            {
+                ticks[zone] += thread->ticks[zone];
+                calls[zone] += thread->calls[zone];
+                threads[zone] += thread->calls[zone] > 0u ? 1u : 0u;
+            }
+            for(unsigned int counter = 0; counter < PROFILE_COUNTER_COUNT; ++counter)
+            {
+                counters[counter] += thread->counters[counter];
+            }
+        }
+
+        // Per step figures need the step zone (stepSPH()); runners that call the passes themselves only get totals
+        const std::uint64_t steps {calls[static_cast<unsigned int>(ProfileZoneId::STEP)]};
+        const std::ios::fmtflags flags {out.flags()};
+        out << std::fixed << std::setprecision(3);
+        out << "Profile (" << steps << " steps, time summed over the threads that entered each zone):" << std::endl;
+        out << "  " << std::left << std::setw(20) << "zone" << std::right << std::setw(12) << "calls" << std::setw(14) << "total ms"
+            << std::setw(14) << "us per call" << std::setw(14) << "us per step" << std::setw(9) << "threads" << std::endl;
+        for(unsigned int zone = 0; zone < PROFILE_ZONE_COUNT; ++zone)
+        {
+            if(calls[zone] == 0u)
+            {
+                continue;
+            }
+            const double us {microseconds(ticks[zone])};
+            out << "  " << std::left << std::setw(20) << std::string(2u * PROFILE_ZONES[zone].depth, ' ') + PROFILE_ZONES[zone].name << std::right
+                << std::setw(12) << calls[zone] << std::setw(14) << us * 1e-3 << std::setw(14) << us / static_cast<double>(calls[zone]);
+            if(steps > 0u)
+            {
+                out << std::setw(14) << us / static_cast<double>(steps);
+            }
+            else
+            {
+                out << std::setw(14) << "-";
+            }
+            out << std::setw(9) << threads[zone] << std::endl;
+        }
+        for(unsigned int counter = 0; counter < PROFILE_COUNTER_COUNT; ++counter)
+        {
+            out << "  " << std::left << std::setw(24) << PROFILE_COUNTER_NAMES[counter] << std::right << std::setw(16) << counters[counter];
+            if(steps > 0u)
+            {
+                out << " (" << static_cast<double>(counters[counter]) / static_cast<double>(steps) << " per step)";
+            }
+            out << std::endl;
+        }
+        if(!m_tracePath.empty())
+        {
+            out << "  Trace: " << m_events << " events written to '" << m_tracePath << "'" << std::endl;
+        }
+        out.flags(flags);
+    }
+
+    std::uint64_t m_start {0};
+    double m_nsPerTick {1.0};
+
+    std::string m_tracePath;
+    std::ofstream m_trace;
+    std::uint64_t m_events {0};
+
+    std::vector<std::unique_ptr<ProfileThread>> m_threads;
+    std::mutex m_mutex;
+};
+
+static Profiler& profiler()
+{
+    static Profiler instance;
+    return instance;
+}
+
+ProfileThread* registerProfileThread()
+{
+    return profiler().add();
+}
+
+void flushProfileEvents(ProfileThread& thread)
+{
+    profiler().flush(thread);
+}
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+#endif // SPH_PROFILE
@@ -0,0 +1,169 @@
+#include <reference.hpp>
+
+#include <HSGIL/math/constants.hpp>
+
+#include <cmath>
+#include <algorithm>
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Kernels
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// As the prototypes wrote them, r = ri - rj and |r| < h
+static float poly6Kernel(const float r, const float h)
+{
+    return (315.0f / (64.0f * gil::constants::PI * std::pow(h, 9.0f))) * std::pow(h * h - r * r, 3.0f);
+}
+
+static float poly6GradientKernel(const float r, const float h)
+{
+    return -(945.0f / (32.0f * gil::constants::PI * std::pow(h, 9.0f))) * std::pow(h * h - r * r, 2.0f);
+}
+
+static float poly6LaplacianKernel(const float r, const float h)
+{
+    return -(945.0f / (32.0f * gil::constants::PI * std::pow(h, 9.0f))) * (h * h - r * r) * (3.0f * h * h - 7.0f * r * r);
+}
+
+// Factor of r / |r|, which has no direction for coincident particles
+static float spikyGradientKernel(const float r, const float h)
+{
+    return (-45.0f / (gil::constants::PI * std::pow(h, 6.0f))) * std::pow(h - r, 2.0f);
+}
+
+static float viscosityLaplacianKernel(const float r, const float h)
+{
+    return (45.0f / (gil::constants::PI * std::pow(h, 6.0f))) * (h - r);
+}
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Passes
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+void referenceDensityPressure(SPH_State& sim)
+{
+    ParticleSoA& ps = sim.particles;
+    const float h {sim.supportRadius};
+    for(unsigned int i = 0; i < ps.size(); ++i)
+    {
+        float density {0.0f};
+        for(unsigned int j = 0; j < ps.size(); ++j)
+        {
+            const float rx {ps.x[i] - ps.x[j]};
+            const float ry {ps.y[i] - ps.y[j]};
+            const float rz {ps.z[i] - ps.z[j]};
+            const float r {std::sqrt(rx * rx + ry * ry + rz * rz)};
+
+            if(r < h)
+            {
+                density += sim.mass * poly6Kernel(r, h);
+            }
+        }
+        ps.density[i] = density + sim.densityOffset;
+        ps.pressure[i] = sim.gasStiffness * (ps.density[i] - sim.restDensity);
+    }
+}
+
+void referenceForces(SPH_State& sim)
+{
+    ParticleSoA& ps = sim.particles;
+    const float h {sim.supportRadius};
+    float maxSpeed2 {0.0f};
+    float maxAcceleration2 {0.0f};
+    for(unsigned int i = 0; i < ps.size(); ++i)
+    {
+        float pressureForce[3] {};
+        float viscosityForce[3] {};
+        float surfaceNormal[3] {};
+        float colorLaplacian {0.0f};
+
+        for(unsigned int j = 0; j < ps.size(); ++j)
+        {
+            if(i == j)
+            {
+                continue;
+            }
+
+            const float r[3] {ps.x[i] - ps.x[j], ps.y[i] - ps.y[j], ps.z[i] - ps.z[j]};
+            const float dv[3] {ps.vx[j] - ps.vx[i], ps.vy[j] - ps.vy[i], ps.vz[j] - ps.vz[i]};
+            const float length {std::sqrt(r[0] * r[0] + r[1] * r[1] + r[2] * r[2])};
+
+            if(length < h)
+            {
+                const float spiky {length > 0.0f ? spikyGradientKernel(length, h) / length : 0.0f};
+                if(sim.forceModel == ForceModel::LEGACY)
+                {
+                    const float pressureScale {sim.mass * (ps.pressure[i] + ps.pressure[j]) / (2.0f * ps.density[j]) * spiky};
+                    const float viscosityScale {sim.viscosity * sim.mass * viscosityLaplacianKernel(length, h) / ps.density[j]};
+                    for(unsigned int k = 0; k < 3; ++k)
+                    {
+                        pressureForce[k] += pressureScale * r[k];
+                        viscosityForce[k] += viscosityScale * dv[k];
+                    }
+                }
+                else
+                {
+                    const float pressureScale {(ps.pressure[i] / (ps.density[i] * ps.density[i]) + ps.pressure[j] / (ps.density[j] * ps.density[j])) * sim.mass * spiky};
+                    const float volume {sim.mass / ps.density[j]};
+                    for(unsigned int k = 0; k < 3; ++k)
+                    {
+                        pressureForce[k] += pressureScale * r[k];
+                        viscosityForce[k] += dv[k] * volume * viscosityLaplacianKernel(length, h);
+                        surfaceNormal[k] += volume * poly6GradientKernel(length, h) * r[k];
+                    }
+                    colorLaplacian += volume * poly6LaplacianKernel(length, h);
+                }
+            }
+        }
+
+        float force[3];
+        if(sim.forceModel == ForceModel::LEGACY)
+        {
+            for(unsigned int k = 0; k < 3; ++k)
+            {
+                force[k] = pressureForce[k] + viscosityForce[k];
+            }
+            force[1] -= gil::constants::GAL * ps.density[i];
+        }
+        else
+        {
+            float sfTensionForce[3] {};
+            const float normalLength {std::sqrt(surfaceNormal[0] * surfaceNormal[0] + surfaceNormal[1] * surfaceNormal[1] + surfaceNormal[2] * surfaceNormal[2])};
+            if(normalLength >= sim.threshold)
+            {
+                for(unsigned int k = 0; k < 3; ++k)
+                {
+                    sfTensionForce[k] = -sim.surfaceTension * colorLaplacian * surfaceNormal[k] / normalLength;
+                }
+            }
+            for(unsigned int k = 0; k < 3; ++k)
+            {
+                force[k] = -ps.density[i] * pressureForce[k] + sim.viscosity * viscosityForce[k] + sfTensionForce[k];
+            }
+            force[1] -= gil::constants::GAL * sim.restDensity;
+        }
+        ps.fx[i] = force[0];
+        ps.fy[i] = force[1];
+        ps.fz[i] = force[2];
+
+        const float acceleration2 {(force[0] * force[0] + force[1] * force[1] + force[2] * force[2]) / (ps.density[i] * ps.density[i])};
+        maxSpeed2 = std::max(maxSpeed2, ps.vx[i] * ps.vx[i] + ps.vy[i] * ps.vy[i] + ps.vz[i] * ps.vz[i]);
+        maxAcceleration2 = std::max(maxAcceleration2, acceleration2);
+    }
+    sim.maxSpeed = std::sqrt(maxSpeed2);
+    sim.maxAcceleration = std::sqrt(maxAcceleration2);
+}
+
+void referenceStep(SPH_State& sim)
+{
+    ++sim.stepCount;
+
+    referenceDensityPressure(sim);
+    referenceForces(sim);
+    if(sim.adaptiveTimeStep)
+    {
+        updateTimeStep(sim);
+    }
+    integrate(sim);
+    sim.time += sim.timeStep;
+}
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
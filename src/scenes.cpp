@@ -0,0 +1,753 @@
+#include <scenes.hpp>
+#include <profiler.hpp>
+
+#include <cmath>
+#include <limits>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Volcano Equations
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+static float volcanoF(const float x, const float y)
+{
+    const float d {std::sqrt(x * x + y * y)};
+    return 1.5f * (std::sin(2.0f * d) / d) - 2.0f;
+}
+
+static float volcanoFx(const float x, const float y)
+{
+    const float d {std::sqrt(x * x + y * y)};
+    return (2.0f * x * std::cos(2.0f * d) * d - x * std::sin(2.0f * d)) / ((x * x + y * y) * d);
+}
+
+static float volcanoFy(const float x, const float y)
+{
+    const float d {std::sqrt(x * x + y * y)};
+    return (2.0f * y * std::cos(2.0f * d) * d - y * std::sin(2.0f * d)) / ((x * x + y * y) * d);
+}
+
+// Gradient Method: particles below the heightfield are pushed along its slope and lifted back onto it
+static void volcanoBoundary(const SPH_State& sim, gil::Vec3f& r, gil::Vec3f& v)
+{
+    if(r.y - sim.margin < volcanoF(r.z, r.x))
+    {
+        const gil::Vec3f gradient {volcanoFy(r.z, r.x), 0.0f, volcanoFx(r.z, r.x)};
+        const float s {sim.damping / std::sqrt(gradient.x * gradient.x + gradient.z * gradient.z)};
+
+        v.x += gradient.x * s;
+        v.z += gradient.z * s;
+        r.y = volcanoF(r.z, r.x) + sim.margin;
+        SPH_PROFILE_COUNT(BOUNDARY_HITS, 1u);
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Scene Descriptions
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// A block of particles on a lattice spacing * supportRadius apart, from min (included) to max (excluded), all starting with
+// the same velocity. A block stops filling once the scene has maxParticles particles (0 for no limit)
+struct ParticleBlock
+{
+    gil::Vec3f min;
+    gil::Vec3f max;
+    float spacing;
+    gil::Vec3f velocity;
+    unsigned int maxParticles;
+};
+
+// What the built-in scenes and the scene files describe: the parameters (margin and skin in units of supportRadius, so they
+// follow it) and the particles
+struct SceneDescription
+{
+    SPH_Params params;
+    float margin;
+    float skin;
+    std::vector<ParticleBlock> blocks;
+};
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Scene Setups
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// A block of particles at rest filling the lower octant of the domain, which then shrinks so the block falls into it
+static void addSettlingBlock(SceneDescription& scene)
+{
+    SPH_Params& params {scene.params};
+    const float margin {scene.margin * params.supportRadius};
+    scene.blocks.push_back({{margin, margin, margin}, {params.boundaryWidth * 0.5f, params.boundaryHeight * 0.5f, params.boundaryDepth * 0.5f},
+                            0.6f, {0.0f, 0.0f, 0.0f}, 0u});
+    params.boundaryWidth  *= 0.6f;
+    params.boundaryHeight *= 0.6f;
+    params.boundaryDepth  *= 0.6f;
+}
+
+static void setupBlueFluidScene(SceneDescription& scene)
+{
+    SPH_Params& params {scene.params};
+    params.timeStep = 0.01f;
+    params.adaptiveTimeStep = true;
+    params.cflFactor = 0.4f;
+    params.minTimeStep = 0.001f;
+    params.maxTimeStep = 0.02f;
+    params.restDensity = 998.29f;
+    params.mass = 0.02f;
+    params.viscosity = 3.5f;
+    params.surfaceTension = 0.0728f;
+    params.threshold = 7.065f;
+    params.gasStiffness = 3.0f;
+    params.restitution = 0.0f;
+    params.supportRadius = 0.0457f;
+    params.densityOffset = 0.0f;
+    params.forceModel = ForceModel::STANDARD;
+    params.pressureSolver = PressureSolver::STATE_EQUATION;
+    params.densityTolerance = 0.01f;
+    params.divergenceTolerance = 0.01f;
+    params.minIterations = 3;
+    params.maxIterations = 50;
+    params.symmetricForces = false;
+    params.cachePairs = false;
+    params.integrator = Integrator::LEAPFROG;
+
+    scene.margin = 1.0f;
+    params.damping = -0.5f;
+    params.boundaryWidth = 0.6f;
+    params.boundaryHeight = 0.6f;
+    params.boundaryDepth = 0.6f;
+    params.boundary = boxBoundary;
+
+    scene.skin = 0.2f;
+    params.sortInterval = 16;
+    params.nThreads = 0; // One per core
+
+    scene.blocks.clear();
+    addSettlingBlock(scene);
+}
+
+static void setupVolcanoScene(SceneDescription& scene)
+{
+    setupBlueFluidScene(scene);
+
+    SPH_Params& params {scene.params};
+    params.restDensity = 3000.29f;
+    // The slope push of the volcano boundary is a fixed impulse per step, tuned for this timeStep and for semi-implicit Euler
+    params.timeStep = 0.01f;
+    params.adaptiveTimeStep = false;
+    params.integrator = Integrator::SEMI_IMPLICIT_EULER;
+    params.boundaryWidth = 0.65f;
+    params.boundaryHeight = 0.65f;
+    params.boundaryDepth = 0.65f;
+    params.boundary = volcanoBoundary;
+
+    scene.blocks.clear();
+    addSettlingBlock(scene);
+}
+
+static void setupLegacyScene(SceneDescription& scene)
+{
+    SPH_Params& params {scene.params};
+    params.timeStep = 0.01f;
+    params.adaptiveTimeStep = true;
+    params.cflFactor = 0.4f;
+    params.minTimeStep = 0.001f;
+    params.maxTimeStep = 0.02f;
+    params.restDensity = 1000.0f;
+    params.mass = 64.0f;
+    params.viscosity = 250.0f;
+    params.surfaceTension = 0.0f;
+    params.threshold = 0.0f;
+    params.gasStiffness = 2000.0f;
+    params.restitution = 0.0f;
+    params.supportRadius = 16.0f;
+    params.densityOffset = 8.0f;
+    params.forceModel = ForceModel::LEGACY;
+    params.pressureSolver = PressureSolver::STATE_EQUATION;
+    params.densityTolerance = 0.01f;
+    params.divergenceTolerance = 0.01f;
+    params.minIterations = 3;
+    params.maxIterations = 50;
+    params.symmetricForces = false;
+    params.cachePairs = false;
+    params.integrator = Integrator::SEMI_IMPLICIT_EULER;
+
+    scene.margin = 1.0f;
+    params.damping = -0.125f;
+    params.boundaryWidth = 160.0f;
+    params.boundaryHeight = 160.0f;
+    params.boundaryDepth = 160.0f;
+    params.boundary = floorBoundary;
+
+    scene.skin = 0.2f;
+    params.sortInterval = 16;
+    params.nThreads = 0; // One per core
+
+    // A fountain shooting upwards from the middle of the domain
+    scene.blocks = {{{params.boundaryWidth * 0.1f, params.boundaryHeight * 0.1f, params.boundaryDepth * 0.1f},
+                     {params.boundaryWidth * 0.5f, params.boundaryHeight * 0.5f, params.boundaryDepth * 0.5f}, 0.6f, {0.0f, 32.0f, 0.0f}, 100000u}};
+}
+
+static bool setupBuiltInScene(SceneDescription& scene, const std::string& name)
+{
+    if(name == "blue-fluid")
+    {
+        setupBlueFluidScene(scene);
+        return true;
+    }
+    if(name == "volcano")
+    {
+        setupVolcanoScene(scene);
+        return true;
+    }
+    if(name == "legacy")
+    {
+        setupLegacyScene(scene);
+        return true;
+    }
+    return false;
+}
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Scene Files
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INI-like text: "[section]" headers, "key = value" lines and comments from '#' or ';' to the end of the line. The keys are
+// listed below; vectors are three numbers separated by spaces or commas. A file starts from the parameters and particles of
+// the built-in scene "base" (blue-fluid by default), given first in [scene]; its [block] sections, each one a ParticleBlock,
+// replace the particles of the base. See scenes/*.ini
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+struct FloatKey
+{
+    const char* section;
+    const char* key;
+    float SPH_Params::* field;
+};
+
+struct UnsignedKey
+{
+    const char* section;
+    const char* key;
+    unsigned int SPH_Params::* field;
+};
+
+struct BoolKey
+{
+    const char* section;
+    const char* key;
+    bool SPH_Params::* field;
+};
+
+static const FloatKey FLOAT_KEYS[]
+{
+    {"fluid",    "restDensity",         &SPH_Params::restDensity},
+    {"fluid",    "mass",                &SPH_Params::mass},
+    {"fluid",    "viscosity",           &SPH_Params::viscosity},
+    {"fluid",    "surfaceTension",      &SPH_Params::surfaceTension},
+    {"fluid",    "threshold",           &SPH_Params::threshold},
+    {"fluid",    "gasStiffness",        &SPH_Params::gasStiffness},
+    {"fluid",    "restitution",         &SPH_Params::restitution},
+    {"fluid",    "supportRadius",       &SPH_Params::supportRadius},
+    {"fluid",    "densityOffset",       &SPH_Params::densityOffset},
+    {"time",     "timeStep",            &SPH_Params::timeStep},
+    {"time",     "cflFactor",           &SPH_Params::cflFactor},
+    {"time",     "minTimeStep",         &SPH_Params::minTimeStep},
+    {"time",     "maxTimeStep",         &SPH_Params::maxTimeStep},
+    {"pressure", "densityTolerance",    &SPH_Params::densityTolerance},
+    {"pressure", "divergenceTolerance", &SPH_Params::divergenceTolerance},
+    {"boundary", "width",               &SPH_Params::boundaryWidth},
+    {"boundary", "height",              &SPH_Params::boundaryHeight},
+    {"boundary", "depth",               &SPH_Params::boundaryDepth},
+    {"boundary", "damping",             &SPH_Params::damping}
+};
+
+static const UnsignedKey UNSIGNED_KEYS[]
+{
+    {"pressure",    "minIterations", &SPH_Params::minIterations},
+    {"pressure",    "maxIterations", &SPH_Params::maxIterations},
+    {"performance", "sortInterval",  &SPH_Params::sortInterval},
+    {"performance", "threads",       &SPH_Params::nThreads}
+};
+
+static const BoolKey BOOL_KEYS[]
+{
+    {"time",        "adaptiveTimeStep", &SPH_Params::adaptiveTimeStep},
+    {"performance", "symmetricForces",  &SPH_Params::symmetricForces},
+    {"performance", "cachePairs",       &SPH_Params::cachePairs}
+};
+
+static std::string trim(const std::string& text)
+{
+    const std::size_t first {text.find_first_not_of(" \t\r")};
+    if(first == std::string::npos)
+    {
+        return {};
+    }
+    return text.substr(first, text.find_last_not_of(" \t\r") - first + 1u);
+}
+
+static bool parseFloat(const std::string& value, float& result)
+{
+    char* end;
+    result = std::strtof(value.c_str(), &end);
+    return !value.empty() && *end == '\0' && std::isfinite(result);
+}
+
+static bool parseUnsigned(const std::string& value, unsigned int& result)
+{
+    char* end;
+    const unsigned long number {std::strtoul(value.c_str(), &end, 10)};
+    result = static_cast<unsigned int>(number);
+    return !value.empty() && value[0] != '-' && *end == '\0' && number <= std::numeric_limits<unsigned int>::max();
+}
+
+static bool parseBool(const std::string& value, bool& result)
+{
+    result = value == "true";
+    return value == "true" || value == "false";
+}
+
+static bool parseVec3(const std::string& value, gil::Vec3f& result)
+{
+    std::string text {value};
+    std::replace(text.begin(), text.end(), ',', ' ');
+    std::istringstream stream {text};
+    std::string x, y, z, extra;
+    return (stream >> x >> y >> z) && !(stream >> extra) && parseFloat(x, result.x) && parseFloat(y, result.y) && parseFloat(z, result.z);
+}
+
+// Names of the command lines and scene files, also what pressureSolverName() and integratorName() return
+struct PressureSolverName
+{
+    const char* name;
+    PressureSolver solver;
+};
+
+static const PressureSolverName PRESSURE_SOLVERS[]
+{
+    {"state-equation", PressureSolver::STATE_EQUATION},
+    {"pcisph",         PressureSolver::PCISPH},
+    {"dfsph",          PressureSolver::DFSPH},
+    {"iisph",          PressureSolver::IISPH}
+};
+
+struct IntegratorName
+{
+    const char* name;
+    Integrator integrator;
+};
+
+static const IntegratorName INTEGRATORS[]
+{
+    {"euler",    Integrator::SEMI_IMPLICIT_EULER},
+    {"leapfrog", Integrator::LEAPFROG},
+    {"verlet",   Integrator::VELOCITY_VERLET}
+};
+
+static bool parsePressureSolver(const std::string& name, PressureSolver& result)
+{
+    for(const PressureSolverName& entry : PRESSURE_SOLVERS)
+    {
+        if(name == entry.name)
+        {
+            result = entry.solver;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool parseIntegrator(const std::string& name, Integrator& result)
+{
+    for(const IntegratorName& entry : INTEGRATORS)
+    {
+        if(name == entry.name)
+        {
+            result = entry.integrator;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Sets one key of a section other than [scene] and [block]
+static bool setParameter(SceneDescription& scene, const std::string& section, const std::string& key, const std::string& value, std::string& error)
+{
+    SPH_Params& params {scene.params};
+    bool valid {true};
+    bool found {true};
+    if(section == "fluid" && key == "forceModel")
+    {
+        valid = value == "standard" || value == "legacy";
+        params.forceModel = value == "legacy" ? ForceModel::LEGACY : ForceModel::STANDARD;
+    }
+    else if(section == "time" && key == "integrator")
+    {
+        valid = parseIntegrator(value, params.integrator);
+    }
+    else if(section == "pressure" && key == "solver")
+    {
+        valid = parsePressureSolver(value, params.pressureSolver);
+    }
+    else if(section == "boundary" && key == "type")
+    {
+        const BoundaryFn boundary {boundaryByName(value)};
+        valid = boundary != nullptr;
+        params.boundary = valid ? boundary : params.boundary;
+    }
+    else if(section == "boundary" && key == "margin")
+    {
+        valid = parseFloat(value, scene.margin);
+    }
+    else if(section == "performance" && key == "skin")
+    {
+        valid = parseFloat(value, scene.skin);
+    }
+    else
+    {
+        found = false;
+        for(const FloatKey& entry : FLOAT_KEYS)
+        {
+            if(section == entry.section && key == entry.key)
+            {
+                valid = parseFloat(value, params.*entry.field);
+                found = true;
+            }
+        }
+        for(const UnsignedKey& entry : UNSIGNED_KEYS)
+        {
+            if(section == entry.section && key == entry.key)
+            {
+                valid = parseUnsigned(value, params.*entry.field);
+                found = true;
+            }
+        }
+        for(const BoolKey& entry : BOOL_KEYS)
+        {
+            if(section == entry.section && key == entry.key)
+            {
+                valid = parseBool(value, params.*entry.field);
+                found = true;
+            }
+        }
+    }
+
+    if(!found)
+    {
+        error = "unknown key '" + key + "' in [" + section + "]";
+        return false;
+    }
+    if(!valid)
+    {
+        error = "invalid value '" + value + "' for " + section + "." + key;
+        return false;
+    }
+    return true;
+}
+
+static bool setBlockKey(ParticleBlock& block, const std::string& key, const std::string& value, std::string& error)
+{
+    bool valid {false};
+    if(key == "min")
+    {
+        valid = parseVec3(value, block.min);
+    }
+    else if(key == "max")
+    {
+        valid = parseVec3(value, block.max);
+    }
+    else if(key == "velocity")
+    {
+        valid = parseVec3(value, block.velocity);
+    }
+    else if(key == "spacing")
+    {
+        valid = parseFloat(value, block.spacing) && block.spacing > 0.0f;
+    }
+    else if(key == "maxParticles")
+    {
+        valid = parseUnsigned(value, block.maxParticles);
+    }
+    else
+    {
+        error = "unknown key '" + key + "' in [block]";
+        return false;
+    }
+    if(!valid)
+    {
+        error = "invalid value '" + value + "' for block." + key;
+    }
+    return valid;
+}
+
+static bool readSceneFile(SceneDescription& scene, const std::string& path, std::string& error)
+{
+    std::ifstream file {path};
+    if(!file)
+    {
+        error = "cannot open '" + path + "'";
+        return false;
+    }
+
+    setupBlueFluidScene(scene);
+    std::string section;
+    std::string line;
+    unsigned int lineNumber {0};
+    bool anySetting {false};
+    bool fileBlocks {false};
+    std::vector<bool> blockBounds;
+    const auto fail = [&](const std::string& message)
+    {
+        error = path + ":" + std::to_string(lineNumber) + ": " + message;
+        return false;
+    };
+
+    while(std::getline(file, line))
+    {
+        ++lineNumber;
+        line = trim(line.substr(0, line.find_first_of("#;")));
+        if(line.empty())
+        {
+            continue;
+        }
+        if(line.front() == '[')
+        {
+            if(line.back() != ']')
+            {
+                return fail("malformed section header '" + line + "'");
+            }
+            section = trim(line.substr(1, line.size() - 2u));
+            if(section == "block")
+            {
+                if(!fileBlocks)
+                {
+                    scene.blocks.clear();
+                    fileBlocks = true;
+                }
+                scene.blocks.push_back({{0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}, 0.6f, {0.0f, 0.0f, 0.0f}, 0u});
+                blockBounds.push_back(false);
+            }
+            continue;
+        }
+
+        const std::size_t equals {line.find('=')};
+        if(equals == std::string::npos)
+        {
+            return fail("expected 'key = value', got '" + line + "'");
+        }
+        const std::string key {trim(line.substr(0, equals))};
+        const std::string value {trim(line.substr(equals + 1u))};
+        if(section.empty())
+        {
+            return fail("'" + key + "' is outside of any section");
+        }
+
+        std::string message;
+        if(section == "scene")
+        {
+            if(key != "base")
+            {
+                return fail("unknown key '" + key + "' in [scene]");
+            }
+            if(anySetting)
+            {
+                return fail("the base scene has to come before any other setting");
+            }
+            if(!setupBuiltInScene(scene, value))
+            {
+                return fail("unknown base scene '" + value + "' (available: " + SCENE_NAMES + ")");
+            }
+        }
+        else if(section == "block")
+        {
+            if(!setBlockKey(scene.blocks.back(), key, value, message))
+            {
+                return fail(message);
+            }
+            if(key == "max")
+            {
+                blockBounds.back() = true;
+            }
+        }
+        else if(!setParameter(scene, section, key, value, message))
+        {
+            return fail(message);
+        }
+        anySetting = true;
+    }
+
+    for(const bool bounded : blockBounds)
+    {
+        if(!bounded)
+        {
+            error = path + ": every [block] needs a max corner";
+            return false;
+        }
+    }
+    return true;
+}
+
+// Applies "section.key=value" to a scene loaded from anywhere
+static bool applyOverride(SceneDescription& scene, const std::string& assignment, std::string& error)
+{
+    const std::size_t equals {assignment.find('=')};
+    const std::size_t dot {assignment.find('.')};
+    if(equals == std::string::npos || dot == std::string::npos || dot > equals)
+    {
+        error = "override '" + assignment + "' is not of the form section.key=value";
+        return false;
+    }
+    const std::string section {trim(assignment.substr(0, dot))};
+    if(section == "scene" || section == "block")
+    {
+        error = "[" + section + "] can only be set in a scene file";
+        return false;
+    }
+    std::string message;
+    if(!setParameter(scene, section, trim(assignment.substr(dot + 1u, equals - dot - 1u)), trim(assignment.substr(equals + 1u)), message))
+    {
+        error = "override '" + assignment + "': " + message;
+        return false;
+    }
+    return true;
+}
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Spawners
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+static void spawnBlock(SPH_State& sim, const ParticleBlock& block)
+{
+    const float spacing {sim.supportRadius * block.spacing};
+    gil::Vec3f pos;
+    for(pos.x = block.min.x; pos.x < block.max.x; pos.x += spacing)
+    {
+        for(pos.y = block.min.y; pos.y < block.max.y; pos.y += spacing)
+        {
+            for(pos.z = block.min.z; pos.z < block.max.z && (block.maxParticles == 0u || sim.particles.size() < block.maxParticles); pos.z += spacing)
+            {
+                sim.particles.add(pos, block.velocity);
+            }
+        }
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+bool setPressureSolver(SPH_State& sim, const std::string& name)
+{
+    return parsePressureSolver(name, sim.pressureSolver);
+}
+
+bool setIntegrator(SPH_State& sim, const std::string& name)
+{
+    return parseIntegrator(name, sim.integrator);
+}
+
+const char* pressureSolverName(const PressureSolver solver)
+{
+    for(const PressureSolverName& entry : PRESSURE_SOLVERS)
+    {
+        if(solver == entry.solver)
+        {
+            return entry.name;
+        }
+    }
+    return nullptr;
+}
+
+const char* integratorName(const Integrator integrator)
+{
+    for(const IntegratorName& entry : INTEGRATORS)
+    {
+        if(integrator == entry.integrator)
+        {
+            return entry.name;
+        }
+    }
+    return nullptr;
+}
+
+BoundaryFn boundaryByName(const std::string& name)
+{
+    if(name == "box")
+    {
+        return boxBoundary;
+    }
+    if(name == "floor")
+    {
+        return floorBoundary;
+    }
+    if(name == "volcano")
+    {
+        return volcanoBoundary;
+    }
+    return nullptr;
+}
+
+const char* boundaryName(const BoundaryFn boundary)
+{
+    if(boundary == boxBoundary)
+    {
+        return "box";
+    }
+    if(boundary == floorBoundary)
+    {
+        return "floor";
+    }
+    if(boundary == volcanoBoundary)
+    {
+        return "volcano";
+    }
+    return nullptr;
+}
+
+bool loadScene(SPH_State& sim, const std::string& name, const std::vector<std::string>& overrides, std::string& error)
+{
+    SceneDescription scene;
+    if(!setupBuiltInScene(scene, name) && !readSceneFile(scene, name, error))
+    {
+        return false;
+    }
+    for(const std::string& assignment : overrides)
+    {
+        if(!applyOverride(scene, assignment, error))
+        {
+            return false;
+        }
+    }
+
+    const SPH_Params& params {scene.params};
+    if(!(params.supportRadius > 0.0f && params.timeStep > 0.0f && params.minTimeStep <= params.maxTimeStep && params.minIterations <= params.maxIterations))
+    {
+        error = "'" + name + "' needs supportRadius > 0, timeStep > 0, minTimeStep <= maxTimeStep and minIterations <= maxIterations";
+        return false;
+    }
+
+    static_cast<SPH_Params&>(sim) = params;
+    sim.margin = scene.margin * sim.supportRadius;
+    sim.skin = scene.skin * sim.supportRadius;
+    sim.particles.resize(0u);
+    for(const ParticleBlock& block : scene.blocks)
+    {
+        spawnBlock(sim, block);
+    }
+    return true;
+}
+
+std::vector<std::string> sceneArguments(const int argc, char* argv[], std::vector<std::string>& overrides)
+{
+    std::vector<std::string> positional;
+    for(int i = 1; i < argc; ++i)
+    {
+        const std::string argument {argv[i]};
+        if(argument.find('=') != std::string::npos)
+        {
+            overrides.push_back(argument);
+        }
+        else
+        {
+            positional.push_back(argument);
+        }
+    }
+    return positional;
+}
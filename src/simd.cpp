@@ -0,0 +1,1285 @@
+#include <simd.hpp>
+
+#include <array>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64)
+    #define SPH_SIMD_X86
+    #include <immintrin.h>
+    #if defined(_MSC_VER) && !defined(__clang__)
+        #include <intrin.h>
+        #define SPH_TARGET(isa)
+    #else
+        #define SPH_TARGET(isa) __attribute__((target(isa)))
+        // GCC flags the deliberately undefined registers inside its own AVX-512 intrinsics
+        #pragma GCC diagnostic ignored "-Wuninitialized"
+        #pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+    #endif
+#endif
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Detection
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+SimdLevel detectSimdLevel()
+{
+#if defined(SPH_SIMD_X86) && defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    const bool osxsave {(info[2] & (1 << 27)) != 0};
+    const bool fma {(info[2] & (1 << 12)) != 0};
+    if(!osxsave || !fma)
+    {
+        return SimdLevel::SCALAR;
+    }
+    // The OS has to save the YMM (and ZMM) registers on context switches
+    const unsigned long long xcr0 {_xgetbv(0)};
+    __cpuidex(info, 7, 0);
+    if((info[1] & (1 << 16)) != 0 && (xcr0 & 0xE6) == 0xE6)
+    {
+        return SimdLevel::AVX512;
+    }
+    if((info[1] & (1 << 5)) != 0 && (xcr0 & 0x6) == 0x6)
+    {
+        return SimdLevel::AVX2;
+    }
+    return SimdLevel::SCALAR;
+#elif defined(SPH_SIMD_X86)
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512f"))
+    {
+        return SimdLevel::AVX512;
+    }
+    if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    {
+        return SimdLevel::AVX2;
+    }
+    return SimdLevel::SCALAR;
+#else
+    return SimdLevel::SCALAR;
+#endif
+}
+
+const char* simdLevelName(const SimdLevel level)
+{
+    switch(level)
+    {
+        case SimdLevel::AVX2:   return "AVX2";
+        case SimdLevel::AVX512: return "AVX-512";
+        default:                return "scalar";
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Scalar
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+static float densitySumScalar(const float* x, const float* y, const float* z, const SPHKernel& kernel, const gil::Vec3f& ri, const unsigned int* candidates,
+                              const unsigned int nCandidates)
+{
+    float sum {0.0f};
+    for(unsigned int k = 0; k < nCandidates; ++k)
+    {
+        const unsigned int j {candidates[k]};
+        const gil::Vec3f r {ri.x - x[j], ri.y - y[j], ri.z - z[j]};
+        const float r2 {r.x * r.x + r.y * r.y + r.z * r.z};
+
+        if(r2 < kernel.radius2())
+        {
+            sum += kernel.poly6(r2);
+        }
+    }
+    return sum;
+}
+
+static ForceSums standardForceSumsScalar(const ParticleSoA& ps, const SPHKernel& kernel, const float mass, const unsigned int i,
+                                         const float pressureTermi, const unsigned int* candidates, const unsigned int nCandidates)
+{
+    const gil::Vec3f ri {ps.position(i)};
+    const gil::Vec3f vi {ps.velocity(i)};
+
+    ForceSums sums {};
+    for(unsigned int k = 0; k < nCandidates; ++k)
+    {
+        const unsigned int j {candidates[k]};
+        if(i == j)
+        {
+            continue;
+        }
+
+        const gil::Vec3f r {ri.x - ps.x[j], ri.y - ps.y[j], ri.z - ps.z[j]};
+        const float r2 {r.x * r.x + r.y * r.y + r.z * r.z};
+
+        if(r2 < kernel.radius2())
+        {
+            const float length {std::sqrt(r2)};
+            const float densityj {ps.density[j]};
+            const float volumej {mass / densityj};
+            const float pressureScale {(pressureTermi + ps.pressure[j] / (densityj * densityj)) * mass * kernel.spikyGradient(length)};
+            const float viscosityScale {volumej * kernel.viscosityLaplacian(length)};
+            const float normalScale {volumej * kernel.poly6Gradient(r2)};
+
+            sums.pressure.x      += pressureScale * r.x;
+            sums.pressure.y      += pressureScale * r.y;
+            sums.pressure.z      += pressureScale * r.z;
+            sums.viscosity.x     += (ps.vx[j] - vi.x) * viscosityScale;
+            sums.viscosity.y     += (ps.vy[j] - vi.y) * viscosityScale;
+            sums.viscosity.z     += (ps.vz[j] - vi.z) * viscosityScale;
+            sums.surfaceNormal.x += normalScale * r.x;
+            sums.surfaceNormal.y += normalScale * r.y;
+            sums.surfaceNormal.z += normalScale * r.z;
+            sums.colorLaplacian  += volumej * kernel.poly6Laplacian(r2);
+        }
+    }
+    return sums;
+}
+
+// Sums of the standard force model per particle, in the order of ForceSums
+static constexpr unsigned int PAIR_TERMS {10};
+
+// The pressure gradient and the color field gradient flip sign from one side of a pair to the other, and the viscosity and color
+// Laplacian terms only swap the neighbor volume, so one kernel evaluation serves both particles
+static ForceSums symmetricForceSumsScalar(const ParticleSoA& ps, const SPHKernel& kernel, const float mass, const unsigned int i,
+                                          const float pressureTermi, const unsigned int* neighbors, const unsigned int nPairs, float* sums)
+{
+    const gil::Vec3f ri {ps.position(i)};
+    const gil::Vec3f vi {ps.velocity(i)};
+    const float volumei {mass / ps.density[i]};
+
+    ForceSums sumsi {};
+    for(unsigned int k = 0; k < nPairs; ++k)
+    {
+        const unsigned int j {neighbors[k]};
+        const gil::Vec3f r {ri.x - ps.x[j], ri.y - ps.y[j], ri.z - ps.z[j]};
+        const float r2 {r.x * r.x + r.y * r.y + r.z * r.z};
+
+        if(r2 < kernel.radius2())
+        {
+            const float length {std::sqrt(r2)};
+            const float densityj {ps.density[j]};
+            const float volumej {mass / densityj};
+            const float pressureScale {(pressureTermi + ps.pressure[j] / (densityj * densityj)) * mass * kernel.spikyGradient(length)};
+            const float laplacian {kernel.viscosityLaplacian(length)};
+            const float gradient {kernel.poly6Gradient(r2)};
+            const float colorLaplacian {kernel.poly6Laplacian(r2)};
+            const gil::Vec3f dv {ps.vx[j] - vi.x, ps.vy[j] - vi.y, ps.vz[j] - vi.z};
+            float* sumsj {sums + j * PAIR_STRIDE};
+
+            sumsi.pressure.x      += pressureScale * r.x;
+            sumsi.pressure.y      += pressureScale * r.y;
+            sumsi.pressure.z      += pressureScale * r.z;
+            sumsi.viscosity.x     += volumej * laplacian * dv.x;
+            sumsi.viscosity.y     += volumej * laplacian * dv.y;
+            sumsi.viscosity.z     += volumej * laplacian * dv.z;
+            sumsi.surfaceNormal.x += volumej * gradient * r.x;
+            sumsi.surfaceNormal.y += volumej * gradient * r.y;
+            sumsi.surfaceNormal.z += volumej * gradient * r.z;
+            sumsi.colorLaplacian  += volumej * colorLaplacian;
+
+            sumsj[0] -= pressureScale * r.x;
+            sumsj[1] -= pressureScale * r.y;
+            sumsj[2] -= pressureScale * r.z;
+            sumsj[3] -= volumei * laplacian * dv.x;
+            sumsj[4] -= volumei * laplacian * dv.y;
+            sumsj[5] -= volumei * laplacian * dv.z;
+            sumsj[6] -= volumei * gradient * r.x;
+            sumsj[7] -= volumei * gradient * r.y;
+            sumsj[8] -= volumei * gradient * r.z;
+            sumsj[9] += volumei * colorLaplacian;
+        }
+    }
+    return sumsi;
+}
+
+static float densitySumCachingScalar(const ParticleSoA& ps, const SPHKernel& kernel, const unsigned int i, const unsigned int* candidates,
+                                     const unsigned int nCandidates, const PairEntries& entries, unsigned int& nPairs)
+{
+    const gil::Vec3f ri {ps.position(i)};
+
+    float sum {0.0f};
+    unsigned int n {0};
+    for(unsigned int k = 0; k < nCandidates; ++k)
+    {
+        const unsigned int j {candidates[k]};
+        const gil::Vec3f r {ri.x - ps.x[j], ri.y - ps.y[j], ri.z - ps.z[j]};
+        const float r2 {r.x * r.x + r.y * r.y + r.z * r.z};
+
+        if(r2 < kernel.radius2())
+        {
+            sum += kernel.poly6(r2);
+            if(j != i)
+            {
+                const float length {std::sqrt(r2)};
+                const float invLength {length > 0.0f ? 1.0f / length : 0.0f};
+                entries.neighbors[n] = j;
+                entries.directionX[n] = r.x * invLength;
+                entries.directionY[n] = r.y * invLength;
+                entries.directionZ[n] = r.z * invLength;
+                entries.distance[n] = length;
+                ++n;
+            }
+        }
+    }
+    nPairs = n;
+    return sum;
+}
+
+// The kernels are written in |r| and r / |r|: spikyGradient(|r|) r = spikyScale (h - |r|)² r / |r|, and the color field gradient
+// poly6Gradient(r²) r = poly6Gradient(r²) |r| r / |r|
+static ForceSums standardForceSumsCachedScalar(const ParticleSoA& ps, const SPHKernel& kernel, const float mass, const unsigned int i,
+                                               const float pressureTermi, const PairEntries& entries, const unsigned int nPairs)
+{
+    const gil::Vec3f vi {ps.velocity(i)};
+
+    ForceSums sums {};
+    for(unsigned int k = 0; k < nPairs; ++k)
+    {
+        const unsigned int j {entries.neighbors[k]};
+        const gil::Vec3f direction {entries.directionX[k], entries.directionY[k], entries.directionZ[k]};
+        const float length {entries.distance[k]};
+        const float r2 {length * length};
+        const float hl {kernel.radius() - length};
+
+        const float densityj {ps.density[j]};
+        const float volumej {mass / densityj};
+        const float pressureScale {(pressureTermi + ps.pressure[j] / (densityj * densityj)) * mass * kernel.spikyGradientScale() * hl * hl};
+        const float viscosityScale {volumej * kernel.viscosityLaplacian(length)};
+        const float normalScale {volumej * kernel.poly6Gradient(r2) * length};
+
+        sums.pressure.x      += pressureScale * direction.x;
+        sums.pressure.y      += pressureScale * direction.y;
+        sums.pressure.z      += pressureScale * direction.z;
+        sums.viscosity.x     += (ps.vx[j] - vi.x) * viscosityScale;
+        sums.viscosity.y     += (ps.vy[j] - vi.y) * viscosityScale;
+        sums.viscosity.z     += (ps.vz[j] - vi.z) * viscosityScale;
+        sums.surfaceNormal.x += normalScale * direction.x;
+        sums.surfaceNormal.y += normalScale * direction.y;
+        sums.surfaceNormal.z += normalScale * direction.z;
+        sums.colorLaplacian  += volumej * kernel.poly6Laplacian(r2);
+    }
+    return sums;
+}
+
+static float pairDivergenceSumScalar(const float* vx, const float* vy, const float* vz, const gil::Vec3f& vi, const float* gx, const float* gy,
+                                    const float* gz, const unsigned int* neighbors, const unsigned int nNeighbors)
+{
+    float sum {0.0f};
+    for(unsigned int k = 0; k < nNeighbors; ++k)
+    {
+        const unsigned int j {neighbors[k]};
+        sum += (vi.x - vx[j]) * gx[k] + (vi.y - vy[j]) * gy[k] + (vi.z - vz[j]) * gz[k];
+    }
+    return sum;
+}
+
+static gil::Vec3f pairGradientSumScalar(const float* terms, const float termi, const float* gx, const float* gy, const float* gz,
+                                        const unsigned int* neighbors, const unsigned int nNeighbors)
+{
+    gil::Vec3f sum {0.0f, 0.0f, 0.0f};
+    for(unsigned int k = 0; k < nNeighbors; ++k)
+    {
+        const float s {termi + terms[neighbors[k]]};
+        sum.x += s * gx[k];
+        sum.y += s * gy[k];
+        sum.z += s * gz[k];
+    }
+    return sum;
+}
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+#ifdef SPH_SIMD_X86
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// AVX2 (8 candidates per batch)
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+static inline unsigned int countBits(unsigned int mask)
+{
+    unsigned int count {0};
+    for(; mask != 0u; mask &= mask - 1u)
+    {
+        ++count;
+    }
+    return count;
+}
+
+// For every 8-bit lane mask, the lanes that are set, in order, one byte each: a permutation that moves them to the front
+static constexpr std::array<unsigned long long, 256> compressLanes()
+{
+    std::array<unsigned long long, 256> table {};
+    for(unsigned int mask = 0; mask < 256u; ++mask)
+    {
+        unsigned int n {0};
+        for(unsigned int lane = 0; lane < 8u; ++lane)
+        {
+            if((mask & (1u << lane)) != 0u)
+            {
+                table[mask] |= static_cast<unsigned long long>(lane) << (8u * n);
+                ++n;
+            }
+        }
+    }
+    return table;
+}
+
+static constexpr std::array<unsigned long long, 256> COMPRESS_LANES_AVX2 {compressLanes()};
+
+SPH_TARGET("avx2,fma")
+static inline float horizontalSumAVX2(const __m256 v)
+{
+    const __m128 quad {_mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1))};
+    const __m128 pair {_mm_add_ps(quad, _mm_movehl_ps(quad, quad))};
+    return _mm_cvtss_f32(_mm_add_ss(pair, _mm_shuffle_ps(pair, pair, 0x1)));
+}
+
+// Loads the batch starting at k; lanes past the end of the list are masked out (their index reads as 0, a valid particle)
+SPH_TARGET("avx2,fma")
+static inline __m256i loadBatchAVX2(const unsigned int* candidates, const unsigned int k, const unsigned int nCandidates, __m256& valid)
+{
+    if(k + 8u <= nCandidates)
+    {
+        valid = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(candidates + k));
+    }
+    const __m256i lanes {_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)};
+    const __m256i mask {_mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(nCandidates - k)), lanes)};
+    valid = _mm256_castsi256_ps(mask);
+    return _mm256_maskload_epi32(reinterpret_cast<const int*>(candidates + k), mask);
+}
+
+SPH_TARGET("avx2,fma")
+static float densitySumAVX2(const float* x, const float* y, const float* z, const SPHKernel& kernel, const gil::Vec3f& ri, const unsigned int* candidates,
+                            const unsigned int nCandidates)
+{
+    const __m256 xi {_mm256_set1_ps(ri.x)};
+    const __m256 yi {_mm256_set1_ps(ri.y)};
+    const __m256 zi {_mm256_set1_ps(ri.z)};
+    const __m256 h2 {_mm256_set1_ps(kernel.radius2())};
+
+    __m256 sum {_mm256_setzero_ps()};
+    for(unsigned int k = 0; k < nCandidates; k += 8u)
+    {
+        __m256 valid;
+        const __m256i j {loadBatchAVX2(candidates, k, nCandidates, valid)};
+
+        const __m256 dx {_mm256_sub_ps(xi, _mm256_i32gather_ps(x, j, 4))};
+        const __m256 dy {_mm256_sub_ps(yi, _mm256_i32gather_ps(y, j, 4))};
+        const __m256 dz {_mm256_sub_ps(zi, _mm256_i32gather_ps(z, j, 4))};
+        const __m256 r2 {_mm256_fmadd_ps(dz, dz, _mm256_fmadd_ps(dy, dy, _mm256_mul_ps(dx, dx)))};
+        const __m256 inside {_mm256_and_ps(valid, _mm256_cmp_ps(r2, h2, _CMP_LT_OQ))};
+
+        const __m256 d {_mm256_sub_ps(h2, r2)};
+        sum = _mm256_add_ps(sum, _mm256_and_ps(inside, _mm256_mul_ps(_mm256_mul_ps(d, d), d)));
+    }
+    return kernel.poly6Scale() * horizontalSumAVX2(sum);
+}
+
+SPH_TARGET("avx2,fma")
+static ForceSums standardForceSumsAVX2(const ParticleSoA& ps, const SPHKernel& kernel, const float mass, const unsigned int i,
+                                       const float pressureTermi, const unsigned int* candidates, const unsigned int nCandidates)
+{
+    const __m256 xi {_mm256_set1_ps(ps.x[i])};
+    const __m256 yi {_mm256_set1_ps(ps.y[i])};
+    const __m256 zi {_mm256_set1_ps(ps.z[i])};
+    const __m256 vxi {_mm256_set1_ps(ps.vx[i])};
+    const __m256 vyi {_mm256_set1_ps(ps.vy[i])};
+    const __m256 vzi {_mm256_set1_ps(ps.vz[i])};
+    const __m256i self {_mm256_set1_epi32(static_cast<int>(i))};
+
+    const __m256 zero {_mm256_setzero_ps()};
+    const __m256 h {_mm256_set1_ps(kernel.radius())};
+    const __m256 h2 {_mm256_set1_ps(kernel.radius2())};
+    const __m256 h2x3 {_mm256_set1_ps(3.0f * kernel.radius2())};
+    const __m256 seven {_mm256_set1_ps(7.0f)};
+    const __m256 massv {_mm256_set1_ps(mass)};
+    const __m256 pressureTermiv {_mm256_set1_ps(pressureTermi)};
+    const __m256 spikyCoefficient {_mm256_set1_ps(kernel.spikyGradientScale() * mass)};
+    const __m256 viscosityCoefficient {_mm256_set1_ps(kernel.viscosityScale())};
+    const __m256 gradientCoefficient {_mm256_set1_ps(kernel.poly6GradientScale())};
+
+    __m256 px {zero}, py {zero}, pz {zero};
+    __m256 vx {zero}, vy {zero}, vz {zero};
+    __m256 nx {zero}, ny {zero}, nz {zero};
+    __m256 lap {zero};
+    for(unsigned int k = 0; k < nCandidates; k += 8u)
+    {
+        __m256 valid;
+        const __m256i j {loadBatchAVX2(candidates, k, nCandidates, valid)};
+
+        const __m256 dx {_mm256_sub_ps(xi, _mm256_i32gather_ps(ps.x.data(), j, 4))};
+        const __m256 dy {_mm256_sub_ps(yi, _mm256_i32gather_ps(ps.y.data(), j, 4))};
+        const __m256 dz {_mm256_sub_ps(zi, _mm256_i32gather_ps(ps.z.data(), j, 4))};
+        const __m256 r2 {_mm256_fmadd_ps(dz, dz, _mm256_fmadd_ps(dy, dy, _mm256_mul_ps(dx, dx)))};
+
+        const __m256 notSelf {_mm256_andnot_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(j, self)), valid)};
+        const __m256 inside {_mm256_and_ps(notSelf, _mm256_cmp_ps(r2, h2, _CMP_LT_OQ))};
+        if(_mm256_movemask_ps(inside) == 0)
+        {
+            continue;
+        }
+        // Coincident particles get no pressure (the spiky gradient has no direction there)
+        const __m256 apart {_mm256_and_ps(inside, _mm256_cmp_ps(r2, zero, _CMP_GT_OQ))};
+
+        const __m256 densityj {_mm256_i32gather_ps(ps.density.data(), j, 4)};
+        const __m256 pressurej {_mm256_i32gather_ps(ps.pressure.data(), j, 4)};
+        const __m256 length {_mm256_sqrt_ps(r2)};
+        const __m256 hl {_mm256_sub_ps(h, length)};
+        const __m256 d {_mm256_sub_ps(h2, r2)};
+        const __m256 volumej {_mm256_div_ps(massv, densityj)};
+
+        const __m256 pressureTerm {_mm256_add_ps(pressureTermiv, _mm256_div_ps(pressurej, _mm256_mul_ps(densityj, densityj)))};
+        const __m256 spiky {_mm256_div_ps(_mm256_mul_ps(spikyCoefficient, _mm256_mul_ps(hl, hl)), length)};
+        const __m256 pressureScale {_mm256_and_ps(apart, _mm256_mul_ps(pressureTerm, spiky))};
+        const __m256 viscosityScale {_mm256_and_ps(inside, _mm256_mul_ps(volumej, _mm256_mul_ps(viscosityCoefficient, hl)))};
+        const __m256 gradient {_mm256_mul_ps(_mm256_mul_ps(volumej, gradientCoefficient), d)};
+        const __m256 normalScale {_mm256_and_ps(inside, _mm256_mul_ps(gradient, d))};
+        const __m256 laplacian {_mm256_and_ps(inside, _mm256_mul_ps(gradient, _mm256_fnmadd_ps(seven, r2, h2x3)))};
+
+        px = _mm256_fmadd_ps(pressureScale, dx, px);
+        py = _mm256_fmadd_ps(pressureScale, dy, py);
+        pz = _mm256_fmadd_ps(pressureScale, dz, pz);
+        vx = _mm256_fmadd_ps(viscosityScale, _mm256_sub_ps(_mm256_i32gather_ps(ps.vx.data(), j, 4), vxi), vx);
+        vy = _mm256_fmadd_ps(viscosityScale, _mm256_sub_ps(_mm256_i32gather_ps(ps.vy.data(), j, 4), vyi), vy);
+        vz = _mm256_fmadd_ps(viscosityScale, _mm256_sub_ps(_mm256_i32gather_ps(ps.vz.data(), j, 4), vzi), vz);
+        nx = _mm256_fmadd_ps(normalScale, dx, nx);
+        ny = _mm256_fmadd_ps(normalScale, dy, ny);
+        nz = _mm256_fmadd_ps(normalScale, dz, nz);
+        lap = _mm256_add_ps(lap, laplacian);
+    }
+
+    ForceSums sums;
+    sums.pressure       = {horizontalSumAVX2(px), horizontalSumAVX2(py), horizontalSumAVX2(pz)};
+    sums.viscosity      = {horizontalSumAVX2(vx), horizontalSumAVX2(vy), horizontalSumAVX2(vz)};
+    sums.surfaceNormal  = {horizontalSumAVX2(nx), horizontalSumAVX2(ny), horizontalSumAVX2(nz)};
+    sums.colorLaplacian = horizontalSumAVX2(lap);
+    return sums;
+}
+
+// Without a scatter instruction, the terms of the j side are stored and added to sums one row at a time: the first eight gathered
+// from their lane, the last two one by one
+SPH_TARGET("avx2,fma")
+static ForceSums symmetricForceSumsAVX2(const ParticleSoA& ps, const SPHKernel& kernel, const float mass, const unsigned int i,
+                                        const float pressureTermi, const unsigned int* neighbors, const unsigned int nPairs, float* sums)
+{
+    const __m256 xi {_mm256_set1_ps(ps.x[i])};
+    const __m256 yi {_mm256_set1_ps(ps.y[i])};
+    const __m256 zi {_mm256_set1_ps(ps.z[i])};
+    const __m256 vxi {_mm256_set1_ps(ps.vx[i])};
+    const __m256 vyi {_mm256_set1_ps(ps.vy[i])};
+    const __m256 vzi {_mm256_set1_ps(ps.vz[i])};
+    const float volumei {mass / ps.density[i]};
+
+    const __m256 zero {_mm256_setzero_ps()};
+    const __m256 h {_mm256_set1_ps(kernel.radius())};
+    const __m256 h2 {_mm256_set1_ps(kernel.radius2())};
+    const __m256 h2x3 {_mm256_set1_ps(3.0f * kernel.radius2())};
+    const __m256 seven {_mm256_set1_ps(7.0f)};
+    const __m256 massv {_mm256_set1_ps(mass)};
+    const __m256 volumeiv {_mm256_set1_ps(volumei)};
+    const __m256 minusVolumeiv {_mm256_set1_ps(-volumei)};
+    const __m256 pressureTermiv {_mm256_set1_ps(pressureTermi)};
+    const __m256 spikyCoefficient {_mm256_set1_ps(kernel.spikyGradientScale() * mass)};
+    const __m256 viscosityCoefficient {_mm256_set1_ps(kernel.viscosityScale())};
+    const __m256 gradientCoefficient {_mm256_set1_ps(kernel.poly6GradientScale())};
+
+    __m256 px {zero}, py {zero}, pz {zero};
+    __m256 vx {zero}, vy {zero}, vz {zero};
+    __m256 nx {zero}, ny {zero}, nz {zero};
+    __m256 lap {zero};
+    alignas(32) float terms[PAIR_TERMS][8];
+    // Offsets of one lane's terms in terms
+    const __m256i column {_mm256_setr_epi32(0, 8, 16, 24, 32, 40, 48, 56)};
+    for(unsigned int k = 0; k < nPairs; k += 8u)
+    {
+        __m256 valid;
+        const __m256i j {loadBatchAVX2(neighbors, k, nPairs, valid)};
+
+        const __m256 dx {_mm256_sub_ps(xi, _mm256_i32gather_ps(ps.x.data(), j, 4))};
+        const __m256 dy {_mm256_sub_ps(yi, _mm256_i32gather_ps(ps.y.data(), j, 4))};
+        const __m256 dz {_mm256_sub_ps(zi, _mm256_i32gather_ps(ps.z.data(), j, 4))};
+        const __m256 r2 {_mm256_fmadd_ps(dz, dz, _mm256_fmadd_ps(dy, dy, _mm256_mul_ps(dx, dx)))};
+
+        const __m256 inside {_mm256_and_ps(valid, _mm256_cmp_ps(r2, h2, _CMP_LT_OQ))};
+        const unsigned int insideLanes {static_cast<unsigned int>(_mm256_movemask_ps(inside))};
+        if(insideLanes == 0)
+        {
+            continue;
+        }
+        // Coincident particles get no pressure (the spiky gradient has no direction there)
+        const __m256 apart {_mm256_and_ps(inside, _mm256_cmp_ps(r2, zero, _CMP_GT_OQ))};
+
+        const __m256 densityj {_mm256_i32gather_ps(ps.density.data(), j, 4)};
+        const __m256 pressurej {_mm256_i32gather_ps(ps.pressure.data(), j, 4)};
+        const __m256 length {_mm256_sqrt_ps(r2)};
+        const __m256 hl {_mm256_sub_ps(h, length)};
+        const __m256 d {_mm256_sub_ps(h2, r2)};
+        const __m256 volumej {_mm256_div_ps(massv, densityj)};
+
+        // The kernel terms without the neighbor volume, which differs from one side to the other
+        const __m256 pressureTerm {_mm256_add_ps(pressureTermiv, _mm256_div_ps(pressurej, _mm256_mul_ps(densityj, densityj)))};
+        const __m256 spiky {_mm256_div_ps(_mm256_mul_ps(spikyCoefficient, _mm256_mul_ps(hl, hl)), length)};
+        const __m256 pressureScale {_mm256_and_ps(apart, _mm256_mul_ps(pressureTerm, spiky))};
+        const __m256 viscosityScale {_mm256_and_ps(inside, _mm256_mul_ps(viscosityCoefficient, hl))};
+        const __m256 gradient {_mm256_mul_ps(gradientCoefficient, d)};
+        const __m256 normalScale {_mm256_and_ps(inside, _mm256_mul_ps(gradient, d))};
+        const __m256 laplacian {_mm256_and_ps(inside, _mm256_mul_ps(gradient, _mm256_fnmadd_ps(seven, r2, h2x3)))};
+        const __m256 dvx {_mm256_sub_ps(_mm256_i32gather_ps(ps.vx.data(), j, 4), vxi)};
+        const __m256 dvy {_mm256_sub_ps(_mm256_i32gather_ps(ps.vy.data(), j, 4), vyi)};
+        const __m256 dvz {_mm256_sub_ps(_mm256_i32gather_ps(ps.vz.data(), j, 4), vzi)};
+
+        const __m256 viscosityj {_mm256_mul_ps(volumej, viscosityScale)};
+        const __m256 normalj {_mm256_mul_ps(volumej, normalScale)};
+        px = _mm256_fmadd_ps(pressureScale, dx, px);
+        py = _mm256_fmadd_ps(pressureScale, dy, py);
+        pz = _mm256_fmadd_ps(pressureScale, dz, pz);
+        vx = _mm256_fmadd_ps(viscosityj, dvx, vx);
+        vy = _mm256_fmadd_ps(viscosityj, dvy, vy);
+        vz = _mm256_fmadd_ps(viscosityj, dvz, vz);
+        nx = _mm256_fmadd_ps(normalj, dx, nx);
+        ny = _mm256_fmadd_ps(normalj, dy, ny);
+        nz = _mm256_fmadd_ps(normalj, dz, nz);
+        lap = _mm256_fmadd_ps(volumej, laplacian, lap);
+
+        const __m256 viscosityi {_mm256_mul_ps(minusVolumeiv, viscosityScale)};
+        const __m256 normali {_mm256_mul_ps(minusVolumeiv, normalScale)};
+        _mm256_store_ps(terms[0], _mm256_sub_ps(zero, _mm256_mul_ps(pressureScale, dx)));
+        _mm256_store_ps(terms[1], _mm256_sub_ps(zero, _mm256_mul_ps(pressureScale, dy)));
+        _mm256_store_ps(terms[2], _mm256_sub_ps(zero, _mm256_mul_ps(pressureScale, dz)));
+        _mm256_store_ps(terms[3], _mm256_mul_ps(viscosityi, dvx));
+        _mm256_store_ps(terms[4], _mm256_mul_ps(viscosityi, dvy));
+        _mm256_store_ps(terms[5], _mm256_mul_ps(viscosityi, dvz));
+        _mm256_store_ps(terms[6], _mm256_mul_ps(normali, dx));
+        _mm256_store_ps(terms[7], _mm256_mul_ps(normali, dy));
+        _mm256_store_ps(terms[8], _mm256_mul_ps(normali, dz));
+        _mm256_store_ps(terms[9], _mm256_mul_ps(volumeiv, laplacian));
+        for(unsigned int lane = 0; lane < 8u; ++lane)
+        {
+            if((insideLanes & (1u << lane)) == 0u)
+            {
+                continue;
+            }
+            float* sumsj {sums + neighbors[k + lane] * PAIR_STRIDE};
+            _mm256_store_ps(sumsj, _mm256_add_ps(_mm256_load_ps(sumsj), _mm256_i32gather_ps(&terms[0][lane], column, 4)));
+            sumsj[8] += terms[8][lane];
+            sumsj[9] += terms[9][lane];
+        }
+    }
+
+    ForceSums sumsi;
+    sumsi.pressure       = {horizontalSumAVX2(px), horizontalSumAVX2(py), horizontalSumAVX2(pz)};
+    sumsi.viscosity      = {horizontalSumAVX2(vx), horizontalSumAVX2(vy), horizontalSumAVX2(vz)};
+    sumsi.surfaceNormal  = {horizontalSumAVX2(nx), horizontalSumAVX2(ny), horizontalSumAVX2(nz)};
+    sumsi.colorLaplacian = horizontalSumAVX2(lap);
+    return sumsi;
+}
+
+// The pair terms are stored per entry, next to the list: the batch is a plain (masked) load, and the padding lanes read as 0
+SPH_TARGET("avx2,fma")
+static inline __m256 loadTermsAVX2(const float* terms, const unsigned int k, const unsigned int nNeighbors)
+{
+    if(k + 8u <= nNeighbors)
+    {
+        return _mm256_loadu_ps(terms + k);
+    }
+    const __m256i lanes {_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)};
+    return _mm256_maskload_ps(terms + k, _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(nNeighbors - k)), lanes));
+}
+
+SPH_TARGET("avx2,fma")
+static float pairDivergenceSumAVX2(const float* vx, const float* vy, const float* vz, const gil::Vec3f& vi, const float* gx, const float* gy,
+                                  const float* gz, const unsigned int* neighbors, const unsigned int nNeighbors)
+{
+    const __m256 vxi {_mm256_set1_ps(vi.x)};
+    const __m256 vyi {_mm256_set1_ps(vi.y)};
+    const __m256 vzi {_mm256_set1_ps(vi.z)};
+
+    __m256 sum {_mm256_setzero_ps()};
+    for(unsigned int k = 0; k < nNeighbors; k += 8u)
+    {
+        __m256 valid;
+        const __m256i j {loadBatchAVX2(neighbors, k, nNeighbors, valid)};
+
+        sum = _mm256_fmadd_ps(_mm256_sub_ps(vxi, _mm256_i32gather_ps(vx, j, 4)), loadTermsAVX2(gx, k, nNeighbors), sum);
+        sum = _mm256_fmadd_ps(_mm256_sub_ps(vyi, _mm256_i32gather_ps(vy, j, 4)), loadTermsAVX2(gy, k, nNeighbors), sum);
+        sum = _mm256_fmadd_ps(_mm256_sub_ps(vzi, _mm256_i32gather_ps(vz, j, 4)), loadTermsAVX2(gz, k, nNeighbors), sum);
+    }
+    return horizontalSumAVX2(sum);
+}
+
+SPH_TARGET("avx2,fma")
+static gil::Vec3f pairGradientSumAVX2(const float* terms, const float termi, const float* gx, const float* gy, const float* gz,
+                                      const unsigned int* neighbors, const unsigned int nNeighbors)
+{
+    const __m256 termiv {_mm256_set1_ps(termi)};
+
+    __m256 sx {_mm256_setzero_ps()}, sy {_mm256_setzero_ps()}, sz {_mm256_setzero_ps()};
+    for(unsigned int k = 0; k < nNeighbors; k += 8u)
+    {
+        __m256 valid;
+        const __m256i j {loadBatchAVX2(neighbors, k, nNeighbors, valid)};
+        const __m256 s {_mm256_add_ps(termiv, _mm256_i32gather_ps(terms, j, 4))};
+
+        sx = _mm256_fmadd_ps(s, loadTermsAVX2(gx, k, nNeighbors), sx);
+        sy = _mm256_fmadd_ps(s, loadTermsAVX2(gy, k, nNeighbors), sy);
+        sz = _mm256_fmadd_ps(s, loadTermsAVX2(gz, k, nNeighbors), sz);
+    }
+    return {horizontalSumAVX2(sx), horizontalSumAVX2(sy), horizontalSumAVX2(sz)};
+}
+
+SPH_TARGET("avx2,fma")
+static float densitySumCachingAVX2(const ParticleSoA& ps, const SPHKernel& kernel, const unsigned int i, const unsigned int* candidates,
+                                   const unsigned int nCandidates, const PairEntries& entries, unsigned int& nPairs)
+{
+    const __m256 xi {_mm256_set1_ps(ps.x[i])};
+    const __m256 yi {_mm256_set1_ps(ps.y[i])};
+    const __m256 zi {_mm256_set1_ps(ps.z[i])};
+    const __m256i self {_mm256_set1_epi32(static_cast<int>(i))};
+    const __m256 zero {_mm256_setzero_ps()};
+    const __m256 one {_mm256_set1_ps(1.0f)};
+    const __m256 h2 {_mm256_set1_ps(kernel.radius2())};
+
+    __m256 sum {zero};
+    unsigned int n {0};
+    for(unsigned int k = 0; k < nCandidates; k += 8u)
+    {
+        __m256 valid;
+        const __m256i j {loadBatchAVX2(candidates, k, nCandidates, valid)};
+
+        const __m256 dx {_mm256_sub_ps(xi, _mm256_i32gather_ps(ps.x.data(), j, 4))};
+        const __m256 dy {_mm256_sub_ps(yi, _mm256_i32gather_ps(ps.y.data(), j, 4))};
+        const __m256 dz {_mm256_sub_ps(zi, _mm256_i32gather_ps(ps.z.data(), j, 4))};
+        const __m256 r2 {_mm256_fmadd_ps(dz, dz, _mm256_fmadd_ps(dy, dy, _mm256_mul_ps(dx, dx)))};
+        const __m256 inside {_mm256_and_ps(valid, _mm256_cmp_ps(r2, h2, _CMP_LT_OQ))};
+
+        const __m256 d {_mm256_sub_ps(h2, r2)};
+        sum = _mm256_add_ps(sum, _mm256_and_ps(inside, _mm256_mul_ps(_mm256_mul_ps(d, d), d)));
+
+        const int pairs {_mm256_movemask_ps(_mm256_andnot_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(j, self)), inside))};
+        if(pairs == 0)
+        {
+            continue;
+        }
+        const __m256 length {_mm256_sqrt_ps(r2)};
+        const __m256 invLength {_mm256_and_ps(_mm256_cmp_ps(r2, zero, _CMP_GT_OQ), _mm256_div_ps(one, length))};
+
+        // AVX2 has no compressing store: the pairs are permuted to the front and the whole batch is stored. n never passes k, so
+        // a full batch stays within the entries of this list; the last one may not, and is copied lane by lane
+        const __m256i front {_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(&COMPRESS_LANES_AVX2[pairs])))};
+        const __m256i indices {_mm256_permutevar8x32_epi32(j, front)};
+        const __m256 directionX {_mm256_permutevar8x32_ps(_mm256_mul_ps(dx, invLength), front)};
+        const __m256 directionY {_mm256_permutevar8x32_ps(_mm256_mul_ps(dy, invLength), front)};
+        const __m256 directionZ {_mm256_permutevar8x32_ps(_mm256_mul_ps(dz, invLength), front)};
+        const __m256 distance {_mm256_permutevar8x32_ps(length, front)};
+        const unsigned int count {countBits(static_cast<unsigned int>(pairs))};
+        if(k + 8u <= nCandidates)
+        {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(entries.neighbors + n), indices);
+            _mm256_storeu_ps(entries.directionX + n, directionX);
+            _mm256_storeu_ps(entries.directionY + n, directionY);
+            _mm256_storeu_ps(entries.directionZ + n, directionZ);
+            _mm256_storeu_ps(entries.distance + n, distance);
+        }
+        else
+        {
+            alignas(32) unsigned int lanes[8];
+            alignas(32) float lanesX[8];
+            alignas(32) float lanesY[8];
+            alignas(32) float lanesZ[8];
+            alignas(32) float lanesDistance[8];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), indices);
+            _mm256_store_ps(lanesX, directionX);
+            _mm256_store_ps(lanesY, directionY);
+            _mm256_store_ps(lanesZ, directionZ);
+            _mm256_store_ps(lanesDistance, distance);
+            for(unsigned int lane = 0; lane < count; ++lane)
+            {
+                entries.neighbors[n + lane] = lanes[lane];
+                entries.directionX[n + lane] = lanesX[lane];
+                entries.directionY[n + lane] = lanesY[lane];
+                entries.directionZ[n + lane] = lanesZ[lane];
+                entries.distance[n + lane] = lanesDistance[lane];
+            }
+        }
+        n += count;
+    }
+    nPairs = n;
+    return kernel.poly6Scale() * horizontalSumAVX2(sum);
+}
+
+// The padding lanes of the last batch load as a pair at distance 0 with particle 0: only the terms that do not vanish there are masked
+SPH_TARGET("avx2,fma")
+static ForceSums standardForceSumsCachedAVX2(const ParticleSoA& ps, const SPHKernel& kernel, const float mass, const unsigned int i,
+                                             const float pressureTermi, const PairEntries& entries, const unsigned int nPairs)
+{
+    const __m256 vxi {_mm256_set1_ps(ps.vx[i])};
+    const __m256 vyi {_mm256_set1_ps(ps.vy[i])};
+    const __m256 vzi {_mm256_set1_ps(ps.vz[i])};
+
+    const __m256 zero {_mm256_setzero_ps()};
+    const __m256 h {_mm256_set1_ps(kernel.radius())};
+    const __m256 h2 {_mm256_set1_ps(kernel.radius2())};
+    const __m256 h2x3 {_mm256_set1_ps(3.0f * kernel.radius2())};
+    const __m256 seven {_mm256_set1_ps(7.0f)};
+    const __m256 massv {_mm256_set1_ps(mass)};
+    const __m256 pressureTermiv {_mm256_set1_ps(pressureTermi)};
+    const __m256 spikyCoefficient {_mm256_set1_ps(kernel.spikyGradientScale() * mass)};
+    const __m256 viscosityCoefficient {_mm256_set1_ps(kernel.viscosityScale())};
+    const __m256 gradientCoefficient {_mm256_set1_ps(kernel.poly6GradientScale())};
+
+    __m256 px {zero}, py {zero}, pz {zero};
+    __m256 vx {zero}, vy {zero}, vz {zero};
+    __m256 nx {zero}, ny {zero}, nz {zero};
+    __m256 lap {zero};
+    for(unsigned int k = 0; k < nPairs; k += 8u)
+    {
+        __m256 valid;
+        const __m256i j {loadBatchAVX2(entries.neighbors, k, nPairs, valid)};
+        const __m256 ux {loadTermsAVX2(entries.directionX, k, nPairs)};
+        const __m256 uy {loadTermsAVX2(entries.directionY, k, nPairs)};
+        const __m256 uz {loadTermsAVX2(entries.directionZ, k, nPairs)};
+        const __m256 length {loadTermsAVX2(entries.distance, k, nPairs)};
+        const __m256 r2 {_mm256_mul_ps(length, length)};
+
+        const __m256 densityj {_mm256_i32gather_ps(ps.density.data(), j, 4)};
+        const __m256 pressurej {_mm256_i32gather_ps(ps.pressure.data(), j, 4)};
+        const __m256 hl {_mm256_sub_ps(h, length)};
+        const __m256 d {_mm256_sub_ps(h2, r2)};
+        const __m256 volumej {_mm256_div_ps(massv, densityj)};
+
+        const __m256 pressureTerm {_mm256_add_ps(pressureTermiv, _mm256_div_ps(pressurej, _mm256_mul_ps(densityj, densityj)))};
+        const __m256 pressureScale {_mm256_mul_ps(pressureTerm, _mm256_mul_ps(spikyCoefficient, _mm256_mul_ps(hl, hl)))};
+        const __m256 viscosityScale {_mm256_and_ps(valid, _mm256_mul_ps(volumej, _mm256_mul_ps(viscosityCoefficient, hl)))};
+        const __m256 gradient {_mm256_mul_ps(_mm256_mul_ps(volumej, gradientCoefficient), d)};
+        const __m256 normalScale {_mm256_mul_ps(_mm256_mul_ps(gradient, d), length)};
+        const __m256 laplacian {_mm256_and_ps(valid, _mm256_mul_ps(gradient, _mm256_fnmadd_ps(seven, r2, h2x3)))};
+
+        px = _mm256_fmadd_ps(pressureScale, ux, px);
+        py = _mm256_fmadd_ps(pressureScale, uy, py);
+        pz = _mm256_fmadd_ps(pressureScale, uz, pz);
+        vx = _mm256_fmadd_ps(viscosityScale, _mm256_sub_ps(_mm256_i32gather_ps(ps.vx.data(), j, 4), vxi), vx);
+        vy = _mm256_fmadd_ps(viscosityScale, _mm256_sub_ps(_mm256_i32gather_ps(ps.vy.data(), j, 4), vyi), vy);
+        vz = _mm256_fmadd_ps(viscosityScale, _mm256_sub_ps(_mm256_i32gather_ps(ps.vz.data(), j, 4), vzi), vz);
+        nx = _mm256_fmadd_ps(normalScale, ux, nx);
+        ny = _mm256_fmadd_ps(normalScale, uy, ny);
+        nz = _mm256_fmadd_ps(normalScale, uz, nz);
+        lap = _mm256_add_ps(lap, laplacian);
+    }
+
+    ForceSums sums;
+    sums.pressure       = {horizontalSumAVX2(px), horizontalSumAVX2(py), horizontalSumAVX2(pz)};
+    sums.viscosity      = {horizontalSumAVX2(vx), horizontalSumAVX2(vy), horizontalSumAVX2(vz)};
+    sums.surfaceNormal  = {horizontalSumAVX2(nx), horizontalSumAVX2(ny), horizontalSumAVX2(nz)};
+    sums.colorLaplacian = horizontalSumAVX2(lap);
+    return sums;
+}
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// AVX-512 (16 candidates per batch)
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+SPH_TARGET("avx512f")
+static inline __m512i loadBatchAVX512(const unsigned int* candidates, const unsigned int k, const unsigned int nCandidates, __mmask16& valid)
+{
+    const unsigned int remaining {nCandidates - k};
+    valid = remaining >= 16u ? static_cast<__mmask16>(0xFFFF) : static_cast<__mmask16>((1u << remaining) - 1u);
+    return _mm512_maskz_loadu_epi32(valid, candidates + k);
+}
+
+SPH_TARGET("avx512f")
+static float densitySumAVX512(const float* x, const float* y, const float* z, const SPHKernel& kernel, const gil::Vec3f& ri, const unsigned int* candidates,
+                              const unsigned int nCandidates)
+{
+    const __m512 xi {_mm512_set1_ps(ri.x)};
+    const __m512 yi {_mm512_set1_ps(ri.y)};
+    const __m512 zi {_mm512_set1_ps(ri.z)};
+    const __m512 zero {_mm512_setzero_ps()};
+    const __m512 h2 {_mm512_set1_ps(kernel.radius2())};
+
+    __m512 sum {zero};
+    for(unsigned int k = 0; k < nCandidates; k += 16u)
+    {
+        __mmask16 valid;
+        const __m512i j {loadBatchAVX512(candidates, k, nCandidates, valid)};
+
+        const __m512 dx {_mm512_sub_ps(xi, _mm512_mask_i32gather_ps(zero, valid, j, x, 4))};
+        const __m512 dy {_mm512_sub_ps(yi, _mm512_mask_i32gather_ps(zero, valid, j, y, 4))};
+        const __m512 dz {_mm512_sub_ps(zi, _mm512_mask_i32gather_ps(zero, valid, j, z, 4))};
+        const __m512 r2 {_mm512_fmadd_ps(dz, dz, _mm512_fmadd_ps(dy, dy, _mm512_mul_ps(dx, dx)))};
+        const __mmask16 inside {_mm512_mask_cmp_ps_mask(valid, r2, h2, _CMP_LT_OQ)};
+
+        const __m512 d {_mm512_sub_ps(h2, r2)};
+        sum = _mm512_mask_add_ps(sum, inside, sum, _mm512_mul_ps(_mm512_mul_ps(d, d), d));
+    }
+    return kernel.poly6Scale() * _mm512_reduce_add_ps(sum);
+}
+
+SPH_TARGET("avx512f")
+static ForceSums standardForceSumsAVX512(const ParticleSoA& ps, const SPHKernel& kernel, const float mass, const unsigned int i,
+                                         const float pressureTermi, const unsigned int* candidates, const unsigned int nCandidates)
+{
+    const __m512 xi {_mm512_set1_ps(ps.x[i])};
+    const __m512 yi {_mm512_set1_ps(ps.y[i])};
+    const __m512 zi {_mm512_set1_ps(ps.z[i])};
+    const __m512 vxi {_mm512_set1_ps(ps.vx[i])};
+    const __m512 vyi {_mm512_set1_ps(ps.vy[i])};
+    const __m512 vzi {_mm512_set1_ps(ps.vz[i])};
+    const __m512i self {_mm512_set1_epi32(static_cast<int>(i))};
+
+    const __m512 zero {_mm512_setzero_ps()};
+    const __m512 h {_mm512_set1_ps(kernel.radius())};
+    const __m512 h2 {_mm512_set1_ps(kernel.radius2())};
+    const __m512 h2x3 {_mm512_set1_ps(3.0f * kernel.radius2())};
+    const __m512 seven {_mm512_set1_ps(7.0f)};
+    const __m512 massv {_mm512_set1_ps(mass)};
+    const __m512 pressureTermiv {_mm512_set1_ps(pressureTermi)};
+    const __m512 spikyCoefficient {_mm512_set1_ps(kernel.spikyGradientScale() * mass)};
+    const __m512 viscosityCoefficient {_mm512_set1_ps(kernel.viscosityScale())};
+    const __m512 gradientCoefficient {_mm512_set1_ps(kernel.poly6GradientScale())};
+
+    __m512 px {zero}, py {zero}, pz {zero};
+    __m512 vx {zero}, vy {zero}, vz {zero};
+    __m512 nx {zero}, ny {zero}, nz {zero};
+    __m512 lap {zero};
+    for(unsigned int k = 0; k < nCandidates; k += 16u)
+    {
+        __mmask16 valid;
+        const __m512i j {loadBatchAVX512(candidates, k, nCandidates, valid)};
+
+        const __m512 dx {_mm512_sub_ps(xi, _mm512_mask_i32gather_ps(zero, valid, j, ps.x.data(), 4))};
+        const __m512 dy {_mm512_sub_ps(yi, _mm512_mask_i32gather_ps(zero, valid, j, ps.y.data(), 4))};
+        const __m512 dz {_mm512_sub_ps(zi, _mm512_mask_i32gather_ps(zero, valid, j, ps.z.data(), 4))};
+        const __m512 r2 {_mm512_fmadd_ps(dz, dz, _mm512_fmadd_ps(dy, dy, _mm512_mul_ps(dx, dx)))};
+
+        const __mmask16 notSelf {_mm512_mask_cmpneq_epi32_mask(valid, j, self)};
+        const __mmask16 inside {_mm512_mask_cmp_ps_mask(notSelf, r2, h2, _CMP_LT_OQ)};
+        if(inside == 0)
+        {
+            continue;
+        }
+        // Coincident particles get no pressure (the spiky gradient has no direction there)
+        const __mmask16 apart {_mm512_mask_cmp_ps_mask(inside, r2, zero, _CMP_GT_OQ)};
+
+        const __m512 densityj {_mm512_mask_i32gather_ps(massv, inside, j, ps.density.data(), 4)};
+        const __m512 pressurej {_mm512_mask_i32gather_ps(zero, inside, j, ps.pressure.data(), 4)};
+        const __m512 length {_mm512_sqrt_ps(r2)};
+        const __m512 hl {_mm512_sub_ps(h, length)};
+        const __m512 d {_mm512_sub_ps(h2, r2)};
+        const __m512 volumej {_mm512_div_ps(massv, densityj)};
+
+        const __m512 pressureTerm {_mm512_add_ps(pressureTermiv, _mm512_div_ps(pressurej, _mm512_mul_ps(densityj, densityj)))};
+        const __m512 spiky {_mm512_div_ps(_mm512_mul_ps(spikyCoefficient, _mm512_mul_ps(hl, hl)), length)};
+        const __m512 pressureScale {_mm512_mul_ps(pressureTerm, spiky)};
+        const __m512 viscosityScale {_mm512_mul_ps(volumej, _mm512_mul_ps(viscosityCoefficient, hl))};
+        const __m512 gradient {_mm512_mul_ps(_mm512_mul_ps(volumej, gradientCoefficient), d)};
+        const __m512 normalScale {_mm512_mul_ps(gradient, d)};
+        const __m512 laplacian {_mm512_mul_ps(gradient, _mm512_fnmadd_ps(seven, r2, h2x3))};
+
+        px = _mm512_mask3_fmadd_ps(pressureScale, dx, px, apart);
+        py = _mm512_mask3_fmadd_ps(pressureScale, dy, py, apart);
+        pz = _mm512_mask3_fmadd_ps(pressureScale, dz, pz, apart);
+        vx = _mm512_mask3_fmadd_ps(viscosityScale, _mm512_sub_ps(_mm512_mask_i32gather_ps(vxi, inside, j, ps.vx.data(), 4), vxi), vx, inside);
+        vy = _mm512_mask3_fmadd_ps(viscosityScale, _mm512_sub_ps(_mm512_mask_i32gather_ps(vyi, inside, j, ps.vy.data(), 4), vyi), vy, inside);
+        vz = _mm512_mask3_fmadd_ps(viscosityScale, _mm512_sub_ps(_mm512_mask_i32gather_ps(vzi, inside, j, ps.vz.data(), 4), vzi), vz, inside);
+        nx = _mm512_mask3_fmadd_ps(normalScale, dx, nx, inside);
+        ny = _mm512_mask3_fmadd_ps(normalScale, dy, ny, inside);
+        nz = _mm512_mask3_fmadd_ps(normalScale, dz, nz, inside);
+        lap = _mm512_mask_add_ps(lap, inside, lap, laplacian);
+    }
+
+    ForceSums sums;
+    sums.pressure       = {_mm512_reduce_add_ps(px), _mm512_reduce_add_ps(py), _mm512_reduce_add_ps(pz)};
+    sums.viscosity      = {_mm512_reduce_add_ps(vx), _mm512_reduce_add_ps(vy), _mm512_reduce_add_ps(vz)};
+    sums.surfaceNormal  = {_mm512_reduce_add_ps(nx), _mm512_reduce_add_ps(ny), _mm512_reduce_add_ps(nz)};
+    sums.colorLaplacian = _mm512_reduce_add_ps(lap);
+    return sums;
+}
+
+// The terms of the j side are gathered from sums, added and scattered back, one field at a time
+SPH_TARGET("avx512f")
+static ForceSums symmetricForceSumsAVX512(const ParticleSoA& ps, const SPHKernel& kernel, const float mass, const unsigned int i,
+                                          const float pressureTermi, const unsigned int* neighbors, const unsigned int nPairs, float* sums)
+{
+    const __m512 xi {_mm512_set1_ps(ps.x[i])};
+    const __m512 yi {_mm512_set1_ps(ps.y[i])};
+    const __m512 zi {_mm512_set1_ps(ps.z[i])};
+    const __m512 vxi {_mm512_set1_ps(ps.vx[i])};
+    const __m512 vyi {_mm512_set1_ps(ps.vy[i])};
+    const __m512 vzi {_mm512_set1_ps(ps.vz[i])};
+    const float volumei {mass / ps.density[i]};
+
+    const __m512 zero {_mm512_setzero_ps()};
+    const __m512 h {_mm512_set1_ps(kernel.radius())};
+    const __m512 h2 {_mm512_set1_ps(kernel.radius2())};
+    const __m512 h2x3 {_mm512_set1_ps(3.0f * kernel.radius2())};
+    const __m512 seven {_mm512_set1_ps(7.0f)};
+    const __m512 massv {_mm512_set1_ps(mass)};
+    const __m512 volumeiv {_mm512_set1_ps(volumei)};
+    const __m512 pressureTermiv {_mm512_set1_ps(pressureTermi)};
+    const __m512 spikyCoefficient {_mm512_set1_ps(kernel.spikyGradientScale() * mass)};
+    const __m512 viscosityCoefficient {_mm512_set1_ps(kernel.viscosityScale())};
+    const __m512 gradientCoefficient {_mm512_set1_ps(kernel.poly6GradientScale())};
+    alignas(64) float terms[PAIR_TERMS][16];
+    // Offsets of one lane's terms in terms, and the lanes of a row they fill
+    const __m512i column {_mm512_setr_epi32(0, 16, 32, 48, 64, 80, 96, 112, 128, 144, 0, 0, 0, 0, 0, 0)};
+    const __mmask16 rowMask {static_cast<__mmask16>((1u << PAIR_TERMS) - 1u)};
+
+    __m512 px {zero}, py {zero}, pz {zero};
+    __m512 vx {zero}, vy {zero}, vz {zero};
+    __m512 nx {zero}, ny {zero}, nz {zero};
+    __m512 lap {zero};
+    for(unsigned int k = 0; k < nPairs; k += 16u)
+    {
+        __mmask16 valid;
+        const __m512i j {loadBatchAVX512(neighbors, k, nPairs, valid)};
+
+        const __m512 dx {_mm512_sub_ps(xi, _mm512_mask_i32gather_ps(zero, valid, j, ps.x.data(), 4))};
+        const __m512 dy {_mm512_sub_ps(yi, _mm512_mask_i32gather_ps(zero, valid, j, ps.y.data(), 4))};
+        const __m512 dz {_mm512_sub_ps(zi, _mm512_mask_i32gather_ps(zero, valid, j, ps.z.data(), 4))};
+        const __m512 r2 {_mm512_fmadd_ps(dz, dz, _mm512_fmadd_ps(dy, dy, _mm512_mul_ps(dx, dx)))};
+
+        const __mmask16 inside {_mm512_mask_cmp_ps_mask(valid, r2, h2, _CMP_LT_OQ)};
+        if(inside == 0)
+        {
+            continue;
+        }
+        // Coincident particles get no pressure (the spiky gradient has no direction there)
+        const __mmask16 apart {_mm512_mask_cmp_ps_mask(inside, r2, zero, _CMP_GT_OQ)};
+
+        const __m512 densityj {_mm512_mask_i32gather_ps(massv, inside, j, ps.density.data(), 4)};
+        const __m512 pressurej {_mm512_mask_i32gather_ps(zero, inside, j, ps.pressure.data(), 4)};
+        const __m512 length {_mm512_sqrt_ps(r2)};
+        const __m512 hl {_mm512_sub_ps(h, length)};
+        const __m512 d {_mm512_sub_ps(h2, r2)};
+        const __m512 volumej {_mm512_div_ps(massv, densityj)};
+
+        // The kernel terms without the neighbor volume, which differs from one side to the other
+        const __m512 pressureTerm {_mm512_add_ps(pressureTermiv, _mm512_div_ps(pressurej, _mm512_mul_ps(densityj, densityj)))};
+        const __m512 spiky {_mm512_div_ps(_mm512_mul_ps(spikyCoefficient, _mm512_mul_ps(hl, hl)), length)};
+        const __m512 pressureScale {_mm512_maskz_mul_ps(apart, pressureTerm, spiky)};
+        const __m512 viscosityScale {_mm512_mul_ps(viscosityCoefficient, hl)};
+        const __m512 gradient {_mm512_mul_ps(gradientCoefficient, d)};
+        const __m512 normalScale {_mm512_mul_ps(gradient, d)};
+        const __m512 laplacian {_mm512_mul_ps(gradient, _mm512_fnmadd_ps(seven, r2, h2x3))};
+        const __m512 dvx {_mm512_sub_ps(_mm512_mask_i32gather_ps(vxi, inside, j, ps.vx.data(), 4), vxi)};
+        const __m512 dvy {_mm512_sub_ps(_mm512_mask_i32gather_ps(vyi, inside, j, ps.vy.data(), 4), vyi)};
+        const __m512 dvz {_mm512_sub_ps(_mm512_mask_i32gather_ps(vzi, inside, j, ps.vz.data(), 4), vzi)};
+
+        const __m512 viscosityj {_mm512_mul_ps(volumej, viscosityScale)};
+        const __m512 normalj {_mm512_mul_ps(volumej, normalScale)};
+        px = _mm512_fmadd_ps(pressureScale, dx, px);
+        py = _mm512_fmadd_ps(pressureScale, dy, py);
+        pz = _mm512_fmadd_ps(pressureScale, dz, pz);
+        vx = _mm512_mask3_fmadd_ps(viscosityj, dvx, vx, inside);
+        vy = _mm512_mask3_fmadd_ps(viscosityj, dvy, vy, inside);
+        vz = _mm512_mask3_fmadd_ps(viscosityj, dvz, vz, inside);
+        nx = _mm512_mask3_fmadd_ps(normalj, dx, nx, inside);
+        ny = _mm512_mask3_fmadd_ps(normalj, dy, ny, inside);
+        nz = _mm512_mask3_fmadd_ps(normalj, dz, nz, inside);
+        lap = _mm512_mask3_fmadd_ps(volumej, laplacian, lap, inside);
+
+        const __m512 viscosityi {_mm512_mul_ps(volumeiv, viscosityScale)};
+        const __m512 normali {_mm512_mul_ps(volumeiv, normalScale)};
+        _mm512_store_ps(terms[0], _mm512_mul_ps(pressureScale, dx));
+        _mm512_store_ps(terms[1], _mm512_mul_ps(pressureScale, dy));
+        _mm512_store_ps(terms[2], _mm512_mul_ps(pressureScale, dz));
+        _mm512_store_ps(terms[3], _mm512_mul_ps(viscosityi, dvx));
+        _mm512_store_ps(terms[4], _mm512_mul_ps(viscosityi, dvy));
+        _mm512_store_ps(terms[5], _mm512_mul_ps(viscosityi, dvz));
+        _mm512_store_ps(terms[6], _mm512_mul_ps(normali, dx));
+        _mm512_store_ps(terms[7], _mm512_mul_ps(normali, dy));
+        _mm512_store_ps(terms[8], _mm512_mul_ps(normali, dz));
+        _mm512_store_ps(terms[9], _mm512_sub_ps(zero, _mm512_mul_ps(volumeiv, laplacian)));
+        for(unsigned int lane = 0; lane < 16u; ++lane)
+        {
+            if((inside & (1u << lane)) == 0u)
+            {
+                continue;
+            }
+            float* sumsj {sums + neighbors[k + lane] * PAIR_STRIDE};
+            const __m512 row {_mm512_mask_i32gather_ps(zero, rowMask, column, &terms[0][lane], 4)};
+            _mm512_store_ps(sumsj, _mm512_sub_ps(_mm512_load_ps(sumsj), row));
+        }
+    }
+
+    ForceSums sumsi;
+    sumsi.pressure       = {_mm512_reduce_add_ps(px), _mm512_reduce_add_ps(py), _mm512_reduce_add_ps(pz)};
+    sumsi.viscosity      = {_mm512_reduce_add_ps(vx), _mm512_reduce_add_ps(vy), _mm512_reduce_add_ps(vz)};
+    sumsi.surfaceNormal  = {_mm512_reduce_add_ps(nx), _mm512_reduce_add_ps(ny), _mm512_reduce_add_ps(nz)};
+    sumsi.colorLaplacian = _mm512_reduce_add_ps(lap);
+    return sumsi;
+}
+
+SPH_TARGET("avx512f")
+static float pairDivergenceSumAVX512(const float* vx, const float* vy, const float* vz, const gil::Vec3f& vi, const float* gx, const float* gy,
+                                    const float* gz, const unsigned int* neighbors, const unsigned int nNeighbors)
+{
+    const __m512 vxi {_mm512_set1_ps(vi.x)};
+    const __m512 vyi {_mm512_set1_ps(vi.y)};
+    const __m512 vzi {_mm512_set1_ps(vi.z)};
+
+    __m512 sum {_mm512_setzero_ps()};
+    for(unsigned int k = 0; k < nNeighbors; k += 16u)
+    {
+        __mmask16 valid;
+        const __m512i j {loadBatchAVX512(neighbors, k, nNeighbors, valid)};
+
+        sum = _mm512_mask3_fmadd_ps(_mm512_sub_ps(vxi, _mm512_mask_i32gather_ps(vxi, valid, j, vx, 4)), _mm512_maskz_loadu_ps(valid, gx + k), sum, valid);
+        sum = _mm512_mask3_fmadd_ps(_mm512_sub_ps(vyi, _mm512_mask_i32gather_ps(vyi, valid, j, vy, 4)), _mm512_maskz_loadu_ps(valid, gy + k), sum, valid);
+        sum = _mm512_mask3_fmadd_ps(_mm512_sub_ps(vzi, _mm512_mask_i32gather_ps(vzi, valid, j, vz, 4)), _mm512_maskz_loadu_ps(valid, gz + k), sum, valid);
+    }
+    return _mm512_reduce_add_ps(sum);
+}
+
+SPH_TARGET("avx512f")
+static gil::Vec3f pairGradientSumAVX512(const float* terms, const float termi, const float* gx, const float* gy, const float* gz,
+                                        const unsigned int* neighbors, const unsigned int nNeighbors)
+{
+    const __m512 zero {_mm512_setzero_ps()};
+    const __m512 termiv {_mm512_set1_ps(termi)};
+
+    __m512 sx {zero}, sy {zero}, sz {zero};
+    for(unsigned int k = 0; k < nNeighbors; k += 16u)
+    {
+        __mmask16 valid;
+        const __m512i j {loadBatchAVX512(neighbors, k, nNeighbors, valid)};
+        const __m512 s {_mm512_add_ps(termiv, _mm512_mask_i32gather_ps(zero, valid, j, terms, 4))};
+
+        sx = _mm512_mask3_fmadd_ps(s, _mm512_maskz_loadu_ps(valid, gx + k), sx, valid);
+        sy = _mm512_mask3_fmadd_ps(s, _mm512_maskz_loadu_ps(valid, gy + k), sy, valid);
+        sz = _mm512_mask3_fmadd_ps(s, _mm512_maskz_loadu_ps(valid, gz + k), sz, valid);
+    }
+    return {_mm512_reduce_add_ps(sx), _mm512_reduce_add_ps(sy), _mm512_reduce_add_ps(sz)};
+}
+
+SPH_TARGET("avx512f")
+static float densitySumCachingAVX512(const ParticleSoA& ps, const SPHKernel& kernel, const unsigned int i, const unsigned int* candidates,
+                                     const unsigned int nCandidates, const PairEntries& entries, unsigned int& nPairs)
+{
+    const __m512 xi {_mm512_set1_ps(ps.x[i])};
+    const __m512 yi {_mm512_set1_ps(ps.y[i])};
+    const __m512 zi {_mm512_set1_ps(ps.z[i])};
+    const __m512i self {_mm512_set1_epi32(static_cast<int>(i))};
+    const __m512 zero {_mm512_setzero_ps()};
+    const __m512 one {_mm512_set1_ps(1.0f)};
+    const __m512 h2 {_mm512_set1_ps(kernel.radius2())};
+
+    __m512 sum {zero};
+    unsigned int n {0};
+    for(unsigned int k = 0; k < nCandidates; k += 16u)
+    {
+        __mmask16 valid;
+        const __m512i j {loadBatchAVX512(candidates, k, nCandidates, valid)};
+
+        const __m512 dx {_mm512_sub_ps(xi, _mm512_mask_i32gather_ps(zero, valid, j, ps.x.data(), 4))};
+        const __m512 dy {_mm512_sub_ps(yi, _mm512_mask_i32gather_ps(zero, valid, j, ps.y.data(), 4))};
+        const __m512 dz {_mm512_sub_ps(zi, _mm512_mask_i32gather_ps(zero, valid, j, ps.z.data(), 4))};
+        const __m512 r2 {_mm512_fmadd_ps(dz, dz, _mm512_fmadd_ps(dy, dy, _mm512_mul_ps(dx, dx)))};
+        const __mmask16 inside {_mm512_mask_cmp_ps_mask(valid, r2, h2, _CMP_LT_OQ)};
+
+        const __m512 d {_mm512_sub_ps(h2, r2)};
+        sum = _mm512_mask_add_ps(sum, inside, sum, _mm512_mul_ps(_mm512_mul_ps(d, d), d));
+
+        const __mmask16 pairs {_mm512_mask_cmpneq_epi32_mask(inside, j, self)};
+        if(pairs == 0)
+        {
+            continue;
+        }
+        const __m512 length {_mm512_sqrt_ps(r2)};
+        const __m512 invLength {_mm512_maskz_div_ps(_mm512_mask_cmp_ps_mask(pairs, r2, zero, _CMP_GT_OQ), one, length)};
+        _mm512_mask_compressstoreu_epi32(entries.neighbors + n, pairs, j);
+        _mm512_mask_compressstoreu_ps(entries.directionX + n, pairs, _mm512_mul_ps(dx, invLength));
+        _mm512_mask_compressstoreu_ps(entries.directionY + n, pairs, _mm512_mul_ps(dy, invLength));
+        _mm512_mask_compressstoreu_ps(entries.directionZ + n, pairs, _mm512_mul_ps(dz, invLength));
+        _mm512_mask_compressstoreu_ps(entries.distance + n, pairs, length);
+        n += countBits(pairs);
+    }
+    nPairs = n;
+    return kernel.poly6Scale() * _mm512_reduce_add_ps(sum);
+}
+
+SPH_TARGET("avx512f")
+static ForceSums standardForceSumsCachedAVX512(const ParticleSoA& ps, const SPHKernel& kernel, const float mass, const unsigned int i,
+                                               const float pressureTermi, const PairEntries& entries, const unsigned int nPairs)
+{
+    const __m512 vxi {_mm512_set1_ps(ps.vx[i])};
+    const __m512 vyi {_mm512_set1_ps(ps.vy[i])};
+    const __m512 vzi {_mm512_set1_ps(ps.vz[i])};
+
+    const __m512 zero {_mm512_setzero_ps()};
+    const __m512 h {_mm512_set1_ps(kernel.radius())};
+    const __m512 h2 {_mm512_set1_ps(kernel.radius2())};
+    const __m512 h2x3 {_mm512_set1_ps(3.0f * kernel.radius2())};
+    const __m512 seven {_mm512_set1_ps(7.0f)};
+    const __m512 massv {_mm512_set1_ps(mass)};
+    const __m512 pressureTermiv {_mm512_set1_ps(pressureTermi)};
+    const __m512 spikyCoefficient {_mm512_set1_ps(kernel.spikyGradientScale() * mass)};
+    const __m512 viscosityCoefficient {_mm512_set1_ps(kernel.viscosityScale())};
+    const __m512 gradientCoefficient {_mm512_set1_ps(kernel.poly6GradientScale())};
+
+    __m512 px {zero}, py {zero}, pz {zero};
+    __m512 vx {zero}, vy {zero}, vz {zero};
+    __m512 nx {zero}, ny {zero}, nz {zero};
+    __m512 lap {zero};
+    for(unsigned int k = 0; k < nPairs; k += 16u)
+    {
+        __mmask16 valid;
+        const __m512i j {loadBatchAVX512(entries.neighbors, k, nPairs, valid)};
+        const __m512 ux {_mm512_maskz_loadu_ps(valid, entries.directionX + k)};
+        const __m512 uy {_mm512_maskz_loadu_ps(valid, entries.directionY + k)};
+        const __m512 uz {_mm512_maskz_loadu_ps(valid, entries.directionZ + k)};
+        const __m512 length {_mm512_maskz_loadu_ps(valid, entries.distance + k)};
+        const __m512 r2 {_mm512_mul_ps(length, length)};
+
+        const __m512 densityj {_mm512_mask_i32gather_ps(massv, valid, j, ps.density.data(), 4)};
+        const __m512 pressurej {_mm512_mask_i32gather_ps(zero, valid, j, ps.pressure.data(), 4)};
+        const __m512 hl {_mm512_sub_ps(h, length)};
+        const __m512 d {_mm512_sub_ps(h2, r2)};
+        const __m512 volumej {_mm512_div_ps(massv, densityj)};
+
+        const __m512 pressureTerm {_mm512_add_ps(pressureTermiv, _mm512_div_ps(pressurej, _mm512_mul_ps(densityj, densityj)))};
+        const __m512 pressureScale {_mm512_mul_ps(pressureTerm, _mm512_mul_ps(spikyCoefficient, _mm512_mul_ps(hl, hl)))};
+        const __m512 viscosityScale {_mm512_mul_ps(volumej, _mm512_mul_ps(viscosityCoefficient, hl))};
+        const __m512 gradient {_mm512_mul_ps(_mm512_mul_ps(volumej, gradientCoefficient), d)};
+        const __m512 normalScale {_mm512_mul_ps(_mm512_mul_ps(gradient, d), length)};
+        const __m512 laplacian {_mm512_mul_ps(gradient, _mm512_fnmadd_ps(seven, r2, h2x3))};
+
+        px = _mm512_fmadd_ps(pressureScale, ux, px);
+        py = _mm512_fmadd_ps(pressureScale, uy, py);
+        pz = _mm512_fmadd_ps(pressureScale, uz, pz);
+        vx = _mm512_mask3_fmadd_ps(viscosityScale, _mm512_sub_ps(_mm512_mask_i32gather_ps(vxi, valid, j, ps.vx.data(), 4), vxi), vx, valid);
+        vy = _mm512_mask3_fmadd_ps(viscosityScale, _mm512_sub_ps(_mm512_mask_i32gather_ps(vyi, valid, j, ps.vy.data(), 4), vyi), vy, valid);
+        vz = _mm512_mask3_fmadd_ps(viscosityScale, _mm512_sub_ps(_mm512_mask_i32gather_ps(vzi, valid, j, ps.vz.data(), 4), vzi), vz, valid);
+        nx = _mm512_fmadd_ps(normalScale, ux, nx);
+        ny = _mm512_fmadd_ps(normalScale, uy, ny);
+        nz = _mm512_fmadd_ps(normalScale, uz, nz);
+        lap = _mm512_mask_add_ps(lap, valid, lap, laplacian);
+    }
+
+    ForceSums sums;
+    sums.pressure       = {_mm512_reduce_add_ps(px), _mm512_reduce_add_ps(py), _mm512_reduce_add_ps(pz)};
+    sums.viscosity      = {_mm512_reduce_add_ps(vx), _mm512_reduce_add_ps(vy), _mm512_reduce_add_ps(vz)};
+    sums.surfaceNormal  = {_mm512_reduce_add_ps(nx), _mm512_reduce_add_ps(ny), _mm512_reduce_add_ps(nz)};
+    sums.colorLaplacian = _mm512_reduce_add_ps(lap);
+    return sums;
+}
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+#endif // SPH_SIMD_X86
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Dispatch
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+float densitySum(const SimdLevel level, const float* x, const float* y, const float* z, const SPHKernel& kernel, const gil::Vec3f& ri,
+                 const unsigned int* candidates, const unsigned int nCandidates)
+{
+#ifdef SPH_SIMD_X86
+    if(level == SimdLevel::AVX512)
+    {
+        return densitySumAVX512(x, y, z, kernel, ri, candidates, nCandidates);
+    }
+    if(level == SimdLevel::AVX2)
+    {
+        return densitySumAVX2(x, y, z, kernel, ri, candidates, nCandidates);
+    }
+#endif
+    return densitySumScalar(x, y, z, kernel, ri, candidates, nCandidates);
+}
+
+float densitySum(const SimdLevel level, const ParticleSoA& ps, const SPHKernel& kernel, const gil::Vec3f& ri, const unsigned int* candidates,
+                 const unsigned int nCandidates)
+{
+    return densitySum(level, ps.x.data(), ps.y.data(), ps.z.data(), kernel, ri, candidates, nCandidates);
+}
+
+ForceSums standardForceSums(const SimdLevel level, const ParticleSoA& ps, const SPHKernel& kernel, const float mass, const unsigned int i,
+                            const float pressureTermi, const unsigned int* candidates, const unsigned int nCandidates)
+{
+#ifdef SPH_SIMD_X86
+    if(level == SimdLevel::AVX512)
+    {
+        return standardForceSumsAVX512(ps, kernel, mass, i, pressureTermi, candidates, nCandidates);
+    }
+    if(level == SimdLevel::AVX2)
+    {
+        return standardForceSumsAVX2(ps, kernel, mass, i, pressureTermi, candidates, nCandidates);
+    }
+#endif
+    return standardForceSumsScalar(ps, kernel, mass, i, pressureTermi, candidates, nCandidates);
+}
+
+ForceSums symmetricForceSums(const SimdLevel level, const ParticleSoA& ps, const SPHKernel& kernel, const float mass, const unsigned int i,
+                             const float pressureTermi, const unsigned int* neighbors, const unsigned int nPairs, float* sums)
+{
+#ifdef SPH_SIMD_X86
+    if(level == SimdLevel::AVX512)
+    {
+        return symmetricForceSumsAVX512(ps, kernel, mass, i, pressureTermi, neighbors, nPairs, sums);
+    }
+    if(level == SimdLevel::AVX2)
+    {
+        return symmetricForceSumsAVX2(ps, kernel, mass, i, pressureTermi, neighbors, nPairs, sums);
+    }
+#endif
+    return symmetricForceSumsScalar(ps, kernel, mass, i, pressureTermi, neighbors, nPairs, sums);
+}
+
+float densitySumCaching(const SimdLevel level, const ParticleSoA& ps, const SPHKernel& kernel, const unsigned int i, const unsigned int* candidates,
+                        const unsigned int nCandidates, const PairEntries& entries, unsigned int& nPairs)
+{
+#ifdef SPH_SIMD_X86
+    if(level == SimdLevel::AVX512)
+    {
+        return densitySumCachingAVX512(ps, kernel, i, candidates, nCandidates, entries, nPairs);
+    }
+    if(level == SimdLevel::AVX2)
+    {
+        return densitySumCachingAVX2(ps, kernel, i, candidates, nCandidates, entries, nPairs);
+    }
+#endif
+    return densitySumCachingScalar(ps, kernel, i, candidates, nCandidates, entries, nPairs);
+}
+
+ForceSums standardForceSumsCached(const SimdLevel level, const ParticleSoA& ps, const SPHKernel& kernel, const float mass, const unsigned int i,
+                                  const float pressureTermi, const PairEntries& entries, const unsigned int nPairs)
+{
+#ifdef SPH_SIMD_X86
+    if(level == SimdLevel::AVX512)
+    {
+        return standardForceSumsCachedAVX512(ps, kernel, mass, i, pressureTermi, entries, nPairs);
+    }
+    if(level == SimdLevel::AVX2)
+    {
+        return standardForceSumsCachedAVX2(ps, kernel, mass, i, pressureTermi, entries, nPairs);
+    }
+#endif
+    return standardForceSumsCachedScalar(ps, kernel, mass, i, pressureTermi, entries, nPairs);
+}
+
+float pairDivergenceSum(const SimdLevel level, const float* vx, const float* vy, const float* vz, const gil::Vec3f& vi, const float* gx, const float* gy,
+                        const float* gz, const unsigned int* neighbors, const unsigned int nNeighbors)
+{
+#ifdef SPH_SIMD_X86
+    if(level == SimdLevel::AVX512)
+    {
+        return pairDivergenceSumAVX512(vx, vy, vz, vi, gx, gy, gz, neighbors, nNeighbors);
+    }
+    if(level == SimdLevel::AVX2)
+    {
+        return pairDivergenceSumAVX2(vx, vy, vz, vi, gx, gy, gz, neighbors, nNeighbors);
+    }
+#endif
+    return pairDivergenceSumScalar(vx, vy, vz, vi, gx, gy, gz, neighbors, nNeighbors);
+}
+
+gil::Vec3f pairGradientSum(const SimdLevel level, const float* terms, const float termi, const float* gx, const float* gy, const float* gz,
+                           const unsigned int* neighbors, const unsigned int nNeighbors)
+{
+#ifdef SPH_SIMD_X86
+    if(level == SimdLevel::AVX512)
+    {
+        return pairGradientSumAVX512(terms, termi, gx, gy, gz, neighbors, nNeighbors);
+    }
+    if(level == SimdLevel::AVX2)
+    {
+        return pairGradientSumAVX2(terms, termi, gx, gy, gz, neighbors, nNeighbors);
+    }
+#endif
+    return pairGradientSumScalar(terms, termi, gx, gy, gz, neighbors, nNeighbors);
+}
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
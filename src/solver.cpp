@@ -0,0 +1,554 @@
+#include <solver.hpp>
+#include <profiler.hpp>
+#include <pressureSolvers.hpp>
+
+#include <HSGIL/math/constants.hpp>
+
+#include <cmath>
+#include <algorithm>
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+static float vecLength(const gil::Vec3f& v)
+{
+    return std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+}
+
+// Folds particle i, whose force was just written, into its thread's extrema for the timestep controller
+static void trackExtrema(StepExtrema& extrema, const ParticleSoA& ps, const unsigned int i)
+{
+    const float invDensity {1.0f / ps.density[i]};
+    const float ax {ps.fx[i] * invDensity};
+    const float ay {ps.fy[i] * invDensity};
+    const float az {ps.fz[i] * invDensity};
+    extrema.speed2 = std::max(extrema.speed2, ps.vx[i] * ps.vx[i] + ps.vy[i] * ps.vy[i] + ps.vz[i] * ps.vz[i]);
+    extrema.acceleration2 = std::max(extrema.acceleration2, ax * ax + ay * ay + az * az);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Boundaries
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+void boxBoundary(const SPH_State& sim, gil::Vec3f& r, gil::Vec3f& v)
+{
+    if(r.x - sim.margin < 0.0f)
+    {
+        v.x *= sim.damping;
+        r.x = sim.margin;
+        SPH_PROFILE_COUNT(BOUNDARY_HITS, 1u);
+    }
+    if(r.x + sim.margin > sim.boundaryWidth)
+    {
+        v.x *= sim.damping;
+        r.x = sim.boundaryWidth - sim.margin;
+        SPH_PROFILE_COUNT(BOUNDARY_HITS, 1u);
+    }
+    if(r.y - sim.margin < 0.0f)
+    {
+        v.y *= sim.damping;
+        r.y = sim.margin;
+        SPH_PROFILE_COUNT(BOUNDARY_HITS, 1u);
+    }
+    if(r.z - sim.margin < 0.0f)
+    {
+        v.z *= sim.damping;
+        r.z = sim.margin;
+        SPH_PROFILE_COUNT(BOUNDARY_HITS, 1u);
+    }
+    if(r.z + sim.margin > sim.boundaryDepth)
+    {
+        v.z *= sim.damping;
+        r.z = sim.boundaryDepth - sim.margin;
+        SPH_PROFILE_COUNT(BOUNDARY_HITS, 1u);
+    }
+}
+
+void floorBoundary(const SPH_State& sim, gil::Vec3f& r, gil::Vec3f& v)
+{
+    if(r.y - sim.margin < 0.0f)
+    {
+        v.y *= sim.damping;
+        r.y = sim.margin;
+        SPH_PROFILE_COUNT(BOUNDARY_HITS, 1u);
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Simulation Passes
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+bool usesStateEquation(const SPH_State& sim)
+{
+    return sim.pressureSolver == PressureSolver::STATE_EQUATION || sim.forceModel == ForceModel::LEGACY;
+}
+
+// The force passes that can read the pairs back from the cache (all but the symmetric one)
+static bool cachesPairs(const SPH_State& sim)
+{
+    return sim.cachePairs && (sim.forceModel == ForceModel::LEGACY || !sim.symmetricForces);
+}
+
+#ifdef SPH_PROFILE
+// The profiler's pairs inside the support, counted apart from the density pass so that it keeps its vector loops and its timing
+static void countSupportPairs(SPH_State& sim)
+{
+    const ParticleSoA& ps = sim.particles;
+    const float radius2 {sim.kernel.radius2()};
+    sim.pool.parallelFor(ps.size(), [&](const unsigned int begin, const unsigned int end, const unsigned int)
+    {
+        std::uint64_t pairs {0};
+        for(unsigned int i = begin; i < end; ++i)
+        {
+            sim.neighbors.forEachNeighbor(i, [&](const unsigned int j)
+            {
+                const float dx {ps.x[i] - ps.x[j]};
+                const float dy {ps.y[i] - ps.y[j]};
+                const float dz {ps.z[i] - ps.z[j]};
+                pairs += (j != i && dx * dx + dy * dy + dz * dz < radius2) ? 1u : 0u;
+            });
+        }
+        SPH_PROFILE_COUNT(SUPPORT_PAIRS, pairs);
+    });
+}
+#endif
+
+void computeDensityPressure(SPH_State& sim)
+{
+#ifdef SPH_PROFILE
+    countSupportPairs(sim);
+#endif
+    SPH_PROFILE_ZONE(DENSITY);
+    ParticleSoA& ps = sim.particles;
+    const float gasStiffness {usesStateEquation(sim) ? sim.gasStiffness : 0.0f};
+    const bool caching {cachesPairs(sim)};
+    if(caching)
+    {
+        sim.pairCache.resize(sim.neighbors.entries(), ps.size());
+    }
+    sim.pool.parallelFor(ps.size(), [&](const unsigned int begin, const unsigned int end, const unsigned int)
+    {
+        for(unsigned int i = begin; i < end; ++i)
+        {
+            const unsigned int* candidates {sim.neighbors.neighbors(i)};
+            const unsigned int nCandidates {sim.neighbors.count(i)};
+            SPH_PROFILE_COUNT(PAIR_TESTS, nCandidates);
+            const float sum {caching ? densitySumCaching(sim.simdLevel, ps, sim.kernel, i, candidates, nCandidates, sim.pairCache.entries(sim.neighbors.offset(i)),
+                                                         sim.pairCache.counts[i])
+                                     : densitySum(sim.simdLevel, ps, sim.kernel, ps.position(i), candidates, nCandidates)};
+            const float density {sim.mass * sum + sim.densityOffset};
+            ps.density[i] = density;
+            ps.pressure[i] = gasStiffness * (density - sim.restDensity);
+        }
+    });
+}
+
+static void computeStandardForces(SPH_State& sim)
+{
+    ParticleSoA& ps = sim.particles;
+    const bool cached {cachesPairs(sim)};
+    sim.pool.parallelFor(ps.size(), [&](const unsigned int begin, const unsigned int end, const unsigned int thread)
+    {
+        StepExtrema extrema {};
+        for(unsigned int i = begin; i < end; ++i)
+        {
+            const float densityi {ps.density[i]};
+            const float pressureTermi {ps.pressure[i] / (densityi * densityi)};
+            SPH_PROFILE_COUNT(PAIR_TESTS, cached ? 0u : sim.neighbors.count(i));
+
+            const ForceSums sums {cached ? standardForceSumsCached(sim.simdLevel, ps, sim.kernel, sim.mass, i, pressureTermi, sim.pairCache.entries(sim.neighbors.offset(i)),
+                                                                   sim.pairCache.counts[i])
+                                         : standardForceSums(sim.simdLevel, ps, sim.kernel, sim.mass, i, pressureTermi, sim.neighbors.neighbors(i), sim.neighbors.count(i))};
+            const gil::Vec3f gravityForce {0.0f, -gil::constants::GAL * sim.restDensity, 0.0f};
+            gil::Vec3f sfTensionForce {0.0f, 0.0f, 0.0f};
+
+            const float normalLength {vecLength(sums.surfaceNormal)};
+            if(normalLength >= sim.threshold)
+            {
+                const float s {-sim.surfaceTension * sums.colorLaplacian / normalLength};
+                sfTensionForce = {sums.surfaceNormal.x * s, sums.surfaceNormal.y * s, sums.surfaceNormal.z * s};
+            }
+
+            ps.fx[i] = -densityi * sums.pressure.x + sim.viscosity * sums.viscosity.x + gravityForce.x + sfTensionForce.x;
+            ps.fy[i] = -densityi * sums.pressure.y + sim.viscosity * sums.viscosity.y + gravityForce.y + sfTensionForce.y;
+            ps.fz[i] = -densityi * sums.pressure.z + sim.viscosity * sums.viscosity.z + gravityForce.z + sfTensionForce.z;
+            trackExtrema(extrema, ps, i);
+        }
+        sim.extrema[thread] = extrema;
+    });
+}
+
+// Half-neighbor variant: every pair inside a thread's chunk is visited once, from its lower index (symmetricForceSums()), and its
+// terms are added to both particles. The pairs that cross chunks are visited from both sides, each for its own particle
+// (standardForceSums()), so a thread never writes outside its chunk and its particles' sums are complete once it reaches them
+static void computeStandardForcesSymmetric(SPH_State& sim)
+{
+    ParticleSoA& ps = sim.particles;
+    const unsigned int nParticles {ps.size()};
+    sim.neighbors.buildHalves(sim.pool);
+    sim.pairSums.resize(nParticles * PAIR_STRIDE);
+    const gil::Vec3f gravityForce {0.0f, -gil::constants::GAL * sim.restDensity, 0.0f};
+    sim.pool.parallelFor(nParticles, [&](const unsigned int begin, const unsigned int end, const unsigned int thread)
+    {
+        std::fill(sim.pairSums.begin() + begin * PAIR_STRIDE, sim.pairSums.begin() + end * PAIR_STRIDE, 0.0f);
+
+        StepExtrema extrema {};
+        for(unsigned int i = begin; i < end; ++i)
+        {
+            const float densityi {ps.density[i]};
+            const float pressureTermi {ps.pressure[i] / (densityi * densityi)};
+            const unsigned int* neighbors {sim.neighbors.halfNeighbors(i)};
+            const unsigned int nPairs {sim.neighbors.halfCount(i)};
+            const unsigned int nCross {sim.neighbors.crossCount(i)};
+            SPH_PROFILE_COUNT(PAIR_TESTS, nPairs + nCross);
+
+            // On top of what the lower particles of the chunk have scattered to i
+            const ForceSums half {symmetricForceSums(sim.simdLevel, ps, sim.kernel, sim.mass, i, pressureTermi, neighbors, nPairs, sim.pairSums.data())};
+            const ForceSums cross {nCross == 0u ? ForceSums {} : standardForceSums(sim.simdLevel, ps, sim.kernel, sim.mass, i, pressureTermi, neighbors + nPairs, nCross)};
+            const float* scattered {&sim.pairSums[i * PAIR_STRIDE]};
+            const gil::Vec3f pressure {scattered[0] + half.pressure.x + cross.pressure.x, scattered[1] + half.pressure.y + cross.pressure.y,
+                                       scattered[2] + half.pressure.z + cross.pressure.z};
+            const gil::Vec3f viscosity {scattered[3] + half.viscosity.x + cross.viscosity.x, scattered[4] + half.viscosity.y + cross.viscosity.y,
+                                        scattered[5] + half.viscosity.z + cross.viscosity.z};
+            const gil::Vec3f surfaceNormal {scattered[6] + half.surfaceNormal.x + cross.surfaceNormal.x, scattered[7] + half.surfaceNormal.y + cross.surfaceNormal.y,
+                                            scattered[8] + half.surfaceNormal.z + cross.surfaceNormal.z};
+            const float colorLaplacian {scattered[9] + half.colorLaplacian + cross.colorLaplacian};
+            gil::Vec3f sfTensionForce {0.0f, 0.0f, 0.0f};
+
+            const float normalLength {vecLength(surfaceNormal)};
+            if(normalLength >= sim.threshold)
+            {
+                const float s {-sim.surfaceTension * colorLaplacian / normalLength};
+                sfTensionForce = {surfaceNormal.x * s, surfaceNormal.y * s, surfaceNormal.z * s};
+            }
+
+            ps.fx[i] = -densityi * pressure.x + sim.viscosity * viscosity.x + gravityForce.x + sfTensionForce.x;
+            ps.fy[i] = -densityi * pressure.y + sim.viscosity * viscosity.y + gravityForce.y + sfTensionForce.y;
+            ps.fz[i] = -densityi * pressure.z + sim.viscosity * viscosity.z + gravityForce.z + sfTensionForce.z;
+            trackExtrema(extrema, ps, i);
+        }
+        sim.extrema[thread] = extrema;
+    });
+}
+
+static void computeLegacyForces(SPH_State& sim)
+{
+    ParticleSoA& ps = sim.particles;
+    const SPHKernel& kernel {sim.kernel};
+    const bool cached {cachesPairs(sim)};
+    sim.pool.parallelFor(ps.size(), [&](const unsigned int begin, const unsigned int end, const unsigned int thread)
+    {
+        StepExtrema extrema {};
+        for(unsigned int i = begin; i < end; ++i)
+        {
+            const gil::Vec3f ri {ps.position(i)};
+            const gil::Vec3f vi {ps.velocity(i)};
+            const float pressurei {ps.pressure[i]};
+
+            gil::Vec3f fp {0.0f, 0.0f, 0.0f};
+            gil::Vec3f fv {0.0f, 0.0f, 0.0f};
+
+            const auto addPair = [&](const unsigned int j, const gil::Vec3f& r, const float length)
+            {
+                const float pressureScale {sim.mass * (pressurei + ps.pressure[j]) / (2.0f * ps.density[j]) * kernel.spikyGradient(length)};
+                const float viscosityScale {sim.viscosity * sim.mass * kernel.viscosityLaplacian(length) / ps.density[j]};
+
+                fp.x += pressureScale * r.x;
+                fp.y += pressureScale * r.y;
+                fp.z += pressureScale * r.z;
+                fv.x += (ps.vx[j] - vi.x) * viscosityScale;
+                fv.y += (ps.vy[j] - vi.y) * viscosityScale;
+                fv.z += (ps.vz[j] - vi.z) * viscosityScale;
+            };
+
+            if(cached)
+            {
+                const PairEntries entries {sim.pairCache.entries(sim.neighbors.offset(i))};
+                for(unsigned int k = 0; k < sim.pairCache.counts[i]; ++k)
+                {
+                    const float length {entries.distance[k]};
+                    addPair(entries.neighbors[k], {entries.directionX[k] * length, entries.directionY[k] * length, entries.directionZ[k] * length}, length);
+                }
+            }
+            else
+            {
+                sim.neighbors.forEachNeighbor(i, [&](const unsigned int j)
+                {
+                    if(i == j)
+                    {
+                        return;
+                    }
+                    SPH_PROFILE_COUNT(PAIR_TESTS, 1u);
+
+                    const gil::Vec3f r {ri.x - ps.x[j], ri.y - ps.y[j], ri.z - ps.z[j]};
+                    const float r2 {r.x * r.x + r.y * r.y + r.z * r.z};
+
+                    if(r2 < kernel.radius2())
+                    {
+                        addPair(j, r, std::sqrt(r2));
+                    }
+                });
+            }
+
+            ps.fx[i] = fp.x + fv.x;
+            ps.fy[i] = fp.y + fv.y - gil::constants::GAL * ps.density[i];
+            ps.fz[i] = fp.z + fv.z;
+            trackExtrema(extrema, ps, i);
+        }
+        sim.extrema[thread] = extrema;
+    });
+}
+
+void computeForces(SPH_State& sim)
+{
+    SPH_PROFILE_ZONE(FORCES);
+    sim.extrema.assign(sim.pool.size(), StepExtrema {});
+    if(sim.forceModel == ForceModel::LEGACY)
+    {
+        computeLegacyForces(sim);
+    }
+    else if(sim.symmetricForces)
+    {
+        computeStandardForcesSymmetric(sim);
+    }
+    else
+    {
+        computeStandardForces(sim);
+    }
+
+    StepExtrema extrema {};
+    for(const StepExtrema& threadExtrema : sim.extrema)
+    {
+        extrema.speed2 = std::max(extrema.speed2, threadExtrema.speed2);
+        extrema.acceleration2 = std::max(extrema.acceleration2, threadExtrema.acceleration2);
+    }
+    sim.maxSpeed = std::sqrt(extrema.speed2);
+    sim.maxAcceleration = std::sqrt(extrema.acceleration2);
+}
+
+void updateTimeStep(SPH_State& sim)
+{
+    SPH_PROFILE_ZONE(TIME_STEP);
+    const float h {sim.supportRadius};
+    float timeStep {sim.maxTimeStep};
+    // A particle may not cross more than a fraction of h per step...
+    if(sim.maxSpeed > 0.0f)
+    {
+        timeStep = std::min(timeStep, sim.cflFactor * h / sim.maxSpeed);
+    }
+    // ...nor be pushed that far from rest by its acceleration (the pressure one lags a step behind with a pressure solver)...
+    const float maxAcceleration {sim.maxAcceleration + sim.pressureStats.maxAcceleration};
+    if(maxAcceleration > 0.0f)
+    {
+        timeStep = std::min(timeStep, sim.cflFactor * std::sqrt(h / maxAcceleration));
+    }
+    // ...and viscosity must not diffuse momentum further than h (0.125 h² / ν, with ν the kinematic viscosity)
+    if(sim.viscosity > 0.0f)
+    {
+        timeStep = std::min(timeStep, 0.125f * h * h * sim.restDensity / sim.viscosity);
+    }
+    sim.timeStep = std::max(sim.minTimeStep, timeStep);
+}
+
+void solvePressure(SPH_State& sim)
+{
+    SPH_PROFILE_ZONE(PRESSURE);
+    if(usesStateEquation(sim))
+    {
+        sim.pressureStats = {};
+        return;
+    }
+    switch(sim.pressureSolver)
+    {
+        case PressureSolver::PCISPH: solvePCISPH(sim); break;
+        case PressureSolver::DFSPH:  solveDFSPH(sim);  break;
+        case PressureSolver::IISPH:  solveIISPH(sim);  break;
+        default:                     break;
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Integrators
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// One streaming pass over the SoA arrays, the boundary applied to each particle as soon as it has moved. a = f / ρ is the
+// acceleration of the step and dt0 the previous timeStep, 0 on the first step of a scheme (which turns its correction off)
+template <Integrator S>
+static void integrateParticles(SPH_State& sim)
+{
+    ParticleSoA& ps = sim.particles;
+    IntegratorData& data {sim.integratorData};
+    const float dt {sim.timeStep};
+    const float dt0 {data.previousTimeStep};
+
+    sim.pool.parallelFor(ps.size(), [&](const unsigned int begin, const unsigned int end, const unsigned int)
+    {
+        for(unsigned int i = begin; i < end; ++i)
+        {
+            gil::Vec3f v;
+            gil::Vec3f r;
+            if constexpr(S == Integrator::SEMI_IMPLICIT_EULER)
+            {
+                const float dtOverDensity {dt / ps.density[i]};
+                v = {ps.vx[i] + dtOverDensity * ps.fx[i], ps.vy[i] + dtOverDensity * ps.fy[i], ps.vz[i] + dtOverDensity * ps.fz[i]};
+                r = {ps.x[i] + dt * v.x, ps.y[i] + dt * v.y, ps.z[i] + dt * v.z};
+                sim.boundary(sim, r, v);
+            }
+            else if constexpr(S == Integrator::LEAPFROG)
+            {
+                const float invDensity {1.0f / ps.density[i]};
+                const gil::Vec3f a {ps.fx[i] * invDensity, ps.fy[i] * invDensity, ps.fz[i] * invDensity};
+                // Closing kick of the previous step and opening kick of this one, then the drift
+                const float kick {0.5f * (dt0 + dt)};
+                gil::Vec3f half {data.vx[i] + kick * a.x, data.vy[i] + kick * a.y, data.vz[i] + kick * a.z};
+                r = {ps.x[i] + dt * half.x, ps.y[i] + dt * half.y, ps.z[i] + dt * half.z};
+                sim.boundary(sim, r, half);
+                data.vx[i] = half.x;
+                data.vy[i] = half.y;
+                data.vz[i] = half.z;
+                v = {half.x + 0.5f * dt * a.x, half.y + 0.5f * dt * a.y, half.z + 0.5f * dt * a.z};
+            }
+            else
+            {
+                const float invDensity {1.0f / ps.density[i]};
+                const gil::Vec3f a {ps.fx[i] * invDensity, ps.fy[i] * invDensity, ps.fz[i] * invDensity};
+                // The velocity predicted last step (v0 + dt0 a0) becomes v0 + dt0 (a0 + a) / 2
+                const float correction {0.5f * dt0};
+                const gil::Vec3f vn {ps.vx[i] + correction * (a.x - data.ax[i]), ps.vy[i] + correction * (a.y - data.ay[i]),
+                                     ps.vz[i] + correction * (a.z - data.az[i])};
+                const float drift {0.5f * dt * dt};
+                r = {ps.x[i] + dt * vn.x + drift * a.x, ps.y[i] + dt * vn.y + drift * a.y, ps.z[i] + dt * vn.z + drift * a.z};
+                v = {vn.x + dt * a.x, vn.y + dt * a.y, vn.z + dt * a.z};
+                sim.boundary(sim, r, v);
+                data.ax[i] = a.x;
+                data.ay[i] = a.y;
+                data.az[i] = a.z;
+            }
+            ps.setVelocity(i, v);
+            ps.setPosition(i, r);
+        }
+    });
+    data.previousTimeStep = dt;
+}
+
+// Starts a scheme over when it changed or its arrays are out of step with the particles: the half-step velocities start from the
+// current ones, and the first step has no correction to make
+static void prepareIntegrator(SPH_State& sim, const Integrator scheme)
+{
+    const ParticleSoA& ps = sim.particles;
+    IntegratorData& data {sim.integratorData};
+    const unsigned int nParticles {ps.size()};
+
+    switch(scheme)
+    {
+        case Integrator::LEAPFROG:
+            if(data.scheme != scheme || data.vx.size() != nParticles)
+            {
+                data.vx.assign(ps.vx.begin(), ps.vx.end());
+                data.vy.assign(ps.vy.begin(), ps.vy.end());
+                data.vz.assign(ps.vz.begin(), ps.vz.end());
+                data.previousTimeStep = 0.0f;
+            }
+            break;
+        case Integrator::VELOCITY_VERLET:
+            if(data.scheme != scheme || data.ax.size() != nParticles)
+            {
+                data.ax.assign(nParticles, 0.0f);
+                data.ay.assign(nParticles, 0.0f);
+                data.az.assign(nParticles, 0.0f);
+                data.previousTimeStep = 0.0f;
+            }
+            break;
+        default:
+            break;
+    }
+    data.scheme = scheme;
+}
+
+void integrate(SPH_State& sim)
+{
+    SPH_PROFILE_ZONE(INTEGRATE);
+    const Integrator scheme {usesStateEquation(sim) ? sim.integrator : Integrator::SEMI_IMPLICIT_EULER};
+    prepareIntegrator(sim, scheme);
+    switch(scheme)
+    {
+        case Integrator::LEAPFROG:        integrateParticles<Integrator::LEAPFROG>(sim);            break;
+        case Integrator::VELOCITY_VERLET: integrateParticles<Integrator::VELOCITY_VERLET>(sim);     break;
+        default:                          integrateParticles<Integrator::SEMI_IMPLICIT_EULER>(sim); break;
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Simulation
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// What initSolver() and resumeSolver() share: the kernels, the SIMD level, the threads and their scratch arrays
+static void startSolver(SPH_State& sim)
+{
+    sim.maxSpeed = 0.0f;
+    sim.maxAcceleration = 0.0f;
+    sim.kernel = SPHKernel {sim.supportRadius};
+    sim.simdLevel = detectSimdLevel();
+    sim.pool.start(sim.nThreads);
+    initPressureSolvers(sim);
+}
+
+void initSolver(SPH_State& sim)
+{
+    sim.stepCount = 0;
+    sim.time = 0.0;
+    sim.neighbors.clear();
+    sim.nextSort = 0;
+    sim.integratorData = {};
+    sim.integratorData.scheme = Integrator::SEMI_IMPLICIT_EULER;
+    sim.pressureStats = {};
+    startSolver(sim);
+}
+
+void resumeSolver(SPH_State& sim)
+{
+    // Lists built for other neighborhoods than the current parameters' are rebuilt by the next step
+    if(sim.neighbors.radius() != sim.supportRadius + sim.skin)
+    {
+        sim.neighbors.clear();
+    }
+    startSolver(sim);
+}
+
+bool updateNeighbors(SPH_State& sim)
+{
+    // The lists stay valid until a particle has moved half the skin: two particles closing in from both sides could then have
+    // entered each other's support. Reordering invalidates the indices, so it waits for the next rebuild
+    bool reordered {false};
+    const float listRadius {sim.supportRadius + sim.skin};
+    const float halfSkin {0.5f * sim.skin};
+    if(sim.neighbors.particleCount() != sim.particles.size() || sim.neighbors.maxDisplacement2(sim.particles, sim.pool) > halfSkin * halfSkin)
+    {
+        if(sim.sortInterval != 0 && sim.stepCount >= sim.nextSort)
+        {
+            SPH_PROFILE_ZONE(SORT);
+            sim.grid.zOrderPermutation(sim.particles, listRadius, sim.permutation);
+            sim.particles.permute(sim.permutation);
+            sim.pressureData.permute(sim.permutation);
+            sim.integratorData.permute(sim.permutation);
+            sim.nextSort = sim.stepCount + sim.sortInterval;
+            reordered = true;
+        }
+        {
+            SPH_PROFILE_ZONE(GRID_BUILD);
+            sim.grid.build(sim.particles, listRadius);
+        }
+        SPH_PROFILE_ZONE(NEIGHBOR_LIST);
+        sim.neighbors.build(sim.particles, sim.grid, listRadius, sim.pool);
+        SPH_PROFILE_COUNT(NEIGHBOR_REBUILDS, 1u);
+    }
+    return reordered;
+}
+
+bool stepSPH(SPH_State& sim)
+{
+    SPH_PROFILE_ZONE(STEP);
+    return stepSPH(sim, [](const StepPass) {});
+}
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,262 @@
+#include <cmath>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <iostream>
+#include <algorithm>
+
+#include <scenes.hpp>
+#include <solver.hpp>
+#include <reference.hpp>
+
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Accuracy Tests
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Checks the optimized passes against the reference solver (include/reference.hpp) on the built-in scenes, for every
+// combination of the fast paths: each SIMD level the CPU has, one and several threads, the symmetric and the cached force passes
+// (neighbor lists and Z-order reordering are always on). Two checks per combination:
+//   - passes: from a settled state, the densities and forces of one step, which only differ by rounding
+//   - trajectories: the positions a few steps from the initial state, which also carry the rounding differences forward. Only
+//     as many steps as a scene stays well-conditioned: once a boundary stacks particles on top of each other, the direction
+//     between them comes down to rounding and the runs part ways. The volcano has no trajectory check: it lifts whole columns
+//     onto its heightfield at the first step, and two steps in the runs are already a supportRadius apart, so its passes are
+//     only checked from a settled state
+// Usage: accuracy [scene ...] (all the built-in scenes by default). Exits with a failure if any error is above its tolerance
+// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
+struct Tolerances
+{
+    // Largest density error, relative to restDensity
+    float density;
+    // Largest force error, relative to the largest reference force
+    float force;
+    // Largest position error at the end of the trajectory, relative to supportRadius
+    float position;
+};
+
+struct SceneTest
+{
+    const char* scene;
+    // 0 for no trajectory check
+    unsigned int trajectorySteps;
+    Tolerances tolerances;
+};
+
+static const SceneTest SCENE_TESTS[]
+{
+    {"blue-fluid", 10, {1e-5f, 1e-4f, 1e-4f}},
+    {"volcano",    0,  {1e-5f, 1e-4f, 1e-4f}},
+    {"legacy",     20, {1e-5f, 1e-4f, 1e-4f}}
+};
+
+// Steps run before the pass checks, so the particles have left their lattice
+constexpr unsigned int SETTLE_STEPS {40};
+
+struct FastPath
+{
+    SimdLevel simdLevel;
+    unsigned int nThreads;
+    bool symmetricForces;
+    bool cachePairs;
+};
+
+static std::string pathName(const FastPath& path)
+{
+    return std::string(simdLevelName(path.simdLevel)) + ", " + std::to_string(path.nThreads) + (path.nThreads == 1u ? " thread" : " threads")
+           + (path.symmetricForces ? ", symmetric" : "") + (path.cachePairs ? ", cached pairs" : "");
+}
+
+static std::vector<FastPath> fastPaths()
+{
+    std::vector<FastPath> paths;
+    const SimdLevel widest {detectSimdLevel()};
+    for(const SimdLevel level : {SimdLevel::SCALAR, SimdLevel::AVX2, SimdLevel::AVX512})
+    {
+        if(static_cast<int>(level) > static_cast<int>(widest))
+        {
+            continue;
+        }
+        for(const unsigned int nThreads : {1u, 3u})
+        {
+            for(const bool symmetricForces : {false, true})
+            {
+                for(const bool cachePairs : {false, true})
+                {
+                    paths.push_back({level, nThreads, symmetricForces, cachePairs});
+                }
+            }
+        }
+    }
+    return paths;
+}
+
+static bool loadTestScene(SPH_State& sim, const std::string& scene)
+{
+    std::string error;
+    if(!loadScene(sim, scene, {}, error))
+    {
+        std::cerr << "Cannot load scene '" << scene << "': " << error << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static void setFastPath(SPH_State& sim, const FastPath& path)
+{
+    sim.nThreads = path.nThreads;
+    sim.symmetricForces = path.symmetricForces;
+    sim.cachePairs = path.cachePairs;
+}
+
+static bool report(const std::string& scene, const std::string& check, const FastPath& path, const float error, const float tolerance)
+{
+    const bool passed {error <= tolerance};
+    std::cout << (passed ? "PASS " : "FAIL ") << scene << ", " << check << " (" << pathName(path) << "): " << error << " (tolerance " << tolerance << ")" << std::endl;
+    return passed;
+}
+
+// One step's densities and forces from a settled state, fast path against reference
+static bool checkPasses(const SceneTest& test, const std::vector<FastPath>& paths)
+{
+    SPH_State sim;
+    if(!loadTestScene(sim, test.scene))
+    {
+        return false;
+    }
+    initSolver(sim);
+    for(unsigned int step = 0; step < SETTLE_STEPS; ++step)
+    {
+        stepSPH(sim);
+    }
+
+    bool passed {true};
+    for(const FastPath& path : paths)
+    {
+        setFastPath(sim, path);
+        resumeSolver(sim);
+        sim.simdLevel = path.simdLevel;
+        // Rebuilt, and reordered when a sort is due, by the path under test
+        sim.neighbors.clear();
+        updateNeighbors(sim);
+        computeDensityPressure(sim);
+        computeForces(sim);
+        const ParticleSoA& ps = sim.particles;
+        const FloatArray density {ps.density};
+        const FloatArray fx {ps.fx};
+        const FloatArray fy {ps.fy};
+        const FloatArray fz {ps.fz};
+
+        referenceDensityPressure(sim);
+        referenceForces(sim);
+        float densityError {0.0f};
+        float forceError {0.0f};
+        float maxForce {0.0f};
+        for(unsigned int i = 0; i < ps.size(); ++i)
+        {
+            const float dx {fx[i] - ps.fx[i]};
+            const float dy {fy[i] - ps.fy[i]};
+            const float dz {fz[i] - ps.fz[i]};
+            densityError = std::max(densityError, std::abs(density[i] - ps.density[i]));
+            forceError = std::max(forceError, std::sqrt(dx * dx + dy * dy + dz * dz));
+            maxForce = std::max(maxForce, std::sqrt(ps.fx[i] * ps.fx[i] + ps.fy[i] * ps.fy[i] + ps.fz[i] * ps.fz[i]));
+        }
+        passed = report(test.scene, "densities", path, densityError / sim.restDensity, test.tolerances.density) && passed;
+        passed = report(test.scene, "forces", path, forceError / maxForce, test.tolerances.force) && passed;
+    }
+    return passed;
+}
+
+// Positions test.trajectorySteps from the initial state, fast path against reference, matched by spawn order
+static bool checkTrajectories(const SceneTest& test, const std::vector<FastPath>& paths)
+{
+    SPH_State reference;
+    if(!loadTestScene(reference, test.scene))
+    {
+        return false;
+    }
+    reference.nThreads = 1;
+    initSolver(reference);
+    for(unsigned int step = 0; step < test.trajectorySteps; ++step)
+    {
+        referenceStep(reference);
+    }
+
+    bool passed {true};
+    for(const FastPath& path : paths)
+    {
+        SPH_State sim;
+        if(!loadTestScene(sim, test.scene))
+        {
+            return false;
+        }
+        setFastPath(sim, path);
+        initSolver(sim);
+        sim.simdLevel = path.simdLevel;
+
+        // Spawn index of the particle at each index
+        std::vector<unsigned int> ids(sim.particles.size());
+        for(unsigned int i = 0; i < ids.size(); ++i)
+        {
+            ids[i] = i;
+        }
+        for(unsigned int step = 0; step < test.trajectorySteps; ++step)
+        {
+            if(stepSPH(sim))
+            {
+                std::vector<unsigned int> reordered(ids.size());
+                for(unsigned int k = 0; k < ids.size(); ++k)
+                {
+                    reordered[k] = ids[sim.permutation[k]];
+                }
+                ids.swap(reordered);
+            }
+        }
+
+        const ParticleSoA& ps = sim.particles;
+        const ParticleSoA& rs = reference.particles;
+        float positionError {0.0f};
+        for(unsigned int i = 0; i < ps.size(); ++i)
+        {
+            const unsigned int id {ids[i]};
+            const float dx {ps.x[i] - rs.x[id]};
+            const float dy {ps.y[i] - rs.y[id]};
+            const float dz {ps.z[i] - rs.z[id]};
+            positionError = std::max(positionError, std::sqrt(dx * dx + dy * dy + dz * dz));
+        }
+        passed = report(test.scene, "trajectories", path, positionError / sim.supportRadius, test.tolerances.position) && passed;
+    }
+    return passed;
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<std::string> scenes;
+    for(int k = 1; k < argc; ++k)
+    {
+        scenes.push_back(argv[k]);
+    }
+
+    const std::vector<FastPath> paths {fastPaths()};
+    bool passed {true};
+    unsigned int tested {0};
+    for(const SceneTest& test : SCENE_TESTS)
+    {
+        if(!scenes.empty() && std::find(scenes.begin(), scenes.end(), test.scene) == scenes.end())
+        {
+            continue;
+        }
+        passed = checkPasses(test, paths) && passed;
+        if(test.trajectorySteps > 0u)
+        {
+            passed = checkTrajectories(test, paths) && passed;
+        }
+        ++tested;
+    }
+    if(tested == 0u)
+    {
+        std::cerr << "No such scene to test (built-in scenes: " << SCENE_NAMES << ")" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << (passed ? "All fast paths match the reference solver" : "Some fast paths drifted from the reference solver") << std::endl;
+    return passed ? 0 : EXIT_FAILURE;
+}
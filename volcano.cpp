@@ -1,193 +1,22 @@
 #include <HSGIL/hsgil.hpp>
 
 #include <vector>
+#include <string>
 #include <iostream>
 
-#include <particle.hpp>
-
-#define SQD(v) pow(v, 2.0f)
-#define e gil::constants::E
+#include <scenes.hpp>
+#include <solver.hpp>
+#include <pipeline.hpp>
+#include <particleStream.hpp>
 
 // ---------------------------------------------------------------------------------------------------------------------------------------------------------------
-struct SIM_State
+struct SIM_State : public SPH_State
 {
-    GLuint VAO;
-    GLuint VBO;
-    GLuint stride;
-    std::vector<float> vertexData;
-    std::vector<Particle> particles;
-
-    float timeStep;
-    float restDensity;
-    float mass;
-    float viscosity;
-    float surfaceTension;
-    float threshold;
-    float gasStiffness;
-    float restitution;
-    float supportRadius;
-
-    float damping;
-    float margin;
-    float boundaryWidth;
-    float boundaryHeight;
-    float boundaryDepth;
+    ParticleStream stream;
+    SimulationThread simulation;
 };
 // ---------------------------------------------------------------------------------------------------------------------------------------------------------------
 
-// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
-// Kernels
-// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
-float poly6DefaultKernel(const gil::Vec3f r, const float h)
-{
-    return (315.0f / (64.0f * gil::constants::PI * pow(h, 9.0f))) * pow(SQD(h) - SQD(gil::module(r)), 3.0f);
-}
-
-gil::Vec3f poly6GradientKernel(const gil::Vec3f r, const float h)
-{
-    return -(945.0f / (32.0f * gil::constants::PI * pow(h, 9.0f))) * r * SQD(SQD(h) - SQD(gil::module(r)));
-}
-
-float poly6LaplacianKernel(const gil::Vec3f r, const float h)
-{
-    return -(945.0f / (32.0f * gil::constants::PI * pow(h, 9.0f))) * (SQD(h) - SQD(gil::module(r))) * (3.0f * SQD(h) - 7.0f * SQD(gil::module(r)));
-}
-
-gil::Vec3f spikyGradientKernel(const gil::Vec3f r, const float h)
-{
-    return (-45.0f / (gil::constants::PI * pow(h, 6.0f))) * gil::normalize(r) * SQD(h - gil::module(r));
-}
-
-float viscosityLaplacianKernel(const gil::Vec3f r, const float h)
-{
-    return (45.0f / (gil::constants::PI * pow(h, 6.0f))) * (h - gil::module(r));
-}
-// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
-
-// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
-// Volcano Equations
-// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
-float f(const float x, const float y)
-{
-    return 1.5f * (sin(2.0f * sqrt(SQD(x) + SQD(y))) / sqrt(SQD(x) + SQD(y))) - 2.0f;
-}
-
-float fx(const float x, const float y)
-{
-    return (2.0f * x * cos(2.0f * sqrt(SQD(x) + SQD(y))) * sqrt(SQD(x) + SQD(y)) - x * sin(2.0f * sqrt(SQD(x) + SQD(y)))) / ((SQD(x) + SQD(y)) * sqrt(SQD(x) + SQD(y)));
-}
-
-float fy(const float x, const float y)
-{
-    return (2.0f * y * cos(2.0f * sqrt(SQD(x) + SQD(y))) * sqrt(SQD(x) + SQD(y)) - y * sin(2.0f * sqrt(SQD(x) + SQD(y)))) / ((SQD(x) + SQD(y)) * sqrt(SQD(x) + SQD(y)));
-}
-
-float f3(const float x, const float y)
-{
-    return 2.0f * (sin(pow(e, fabs(x))) + sin(pow(e, fabs(y)) / 2.0f)) / (pow(e, fabs(x)) + pow(e, fabs(y))) - 2.0f;
-}
-// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
-
-// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
-// Leap-Frog Solver
-// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
-void leapFrogIntegrate(SIM_State& sim)
-{
-    for(unsigned int i = 0; i < sim.particles.size(); ++i)
-    {
-        Particle& pi = sim.particles[i];
-
-        pi.v += sim.timeStep * pi.f / pi.density;
-        pi.r += sim.timeStep * pi.v;
-
-        // Dumping Method
-/*
-        if(pi.r.y - sim.margin < f(pi.r.z, pi.r.x))
-        {
-            pi.v.y *= sim.damping;
-            pi.r.y = f(pi.r.z, pi.r.x);
-        }
-*/
-
-        // Venom Method
-/*
-        if(pi.r.y - sim.margin < f(pi.r.z, pi.r.x))
-        {
-            float d {2.0f};
-            glm::vec3 A  {pi.r.z, pi.r.x, pi.r.y};
-            glm::vec3 Ax {A.x + d, A.y, d * fx(A.x, A.y)};
-            glm::vec3 Ay {A.x, A.y + d, d * fy(A.x, A.y)};
-            glm::vec3 Dp {glm::normalize(glm::cross(Ax - A, Ay - A))};
-
-            pi.v += gil::Vec3f{Dp.y, Dp.z, Dp.x} * sim.damping;
-            pi.r.y = f(pi.r.z, pi.r.x) + sim.margin;
-        }
-*/
-
-        // Perpendicular Method
-/*
-        if(pi.r.y - sim.margin < f(pi.r.z, pi.r.x))
-        {
-            float d {2.0f};
-            glm::vec3 A  {pi.r.z, pi.r.x, pi.r.y};
-            glm::vec3 Ax {A.x + d, A.y, d * fx(A.x, A.y)};
-            glm::vec3 Ay {A.x, A.y + d, d * fy(A.x, A.y)};
-            glm::vec3 Dp {glm::normalize(glm::cross(Ay - A, Ax - A))};
-
-            pi.v = gil::Vec3f{Dp.y, Dp.z, Dp.x} * sim.damping;
-            pi.r.y = f(pi.r.z, pi.r.x) + sim.margin;
-        }
-*/
-
-        // Gradient Method
-
-        if(pi.r.y - sim.margin < f(pi.r.z, pi.r.x))
-        {
-            float d {2.0f};
-            gil::Vec3f gradientVector {fy(pi.r.z, pi.r.x), 0.0f, fx(pi.r.z, pi.r.x)};
-
-            pi.v += gil::normalize(gradientVector) * sim.damping;
-            pi.r.y = f(pi.r.z, pi.r.x) + sim.margin;
-        }
-
-
-        // Box Method
-/*
-        if(pi.r.x - sim.margin < 0.0f)
-        {
-            pi.v.x *= sim.damping;
-            pi.r.x = sim.margin;
-        }
-        if(pi.r.x + sim.margin > sim.boundaryWidth)
-        {
-            pi.v.x *= sim.damping;
-            pi.r.x = sim.boundaryWidth - sim.margin;
-        }
-        if(pi.r.y - sim.margin < 0.0f)
-        {
-            pi.v.y *= sim.damping;
-            pi.r.y = sim.margin;
-        }
-        if(pi.r.y + sim.margin > sim.boundaryHeight)
-        {
-            pi.v.y *= sim.damping;
-            pi.r.y = sim.boundaryHeight - sim.margin;
-        }
-        if(pi.r.z - sim.margin < 0.0f)
-        {
-            pi.v.z *= sim.damping;
-            pi.r.z = sim.margin;
-        }
-        if(pi.r.z + sim.margin > sim.boundaryDepth)
-        {
-            pi.v.z *= sim.damping;
-            pi.r.z = sim.boundaryDepth - sim.margin;
-        }
-*/
-    }
-}
-// ---------------------------------------------------------------------------------------------------------------------------------------------------------------
-
 // Init Functions
 // ---------------------------------------------------------------------------------------------------------------------------------------------------------------
 void initGLParams(const SIM_State& sim, const gil::RenderingWindow& window, gil::Shader& particleShader, gil::Shader& volcanoShader, const glm::vec3& viewPos)
@@ -203,6 +32,7 @@ void initGLParams(const SIM_State& sim, const gil::RenderingWindow& window, gil:
     particleShader.use();
     particleShader.setMat4("view", view);
     particleShader.setMat4("projection", projection);
+    particleShader.setFloat("boundaryDepth", sim.boundaryDepth);
     particleShader.setVec3("particleColor", {1.0f, 0.13f, 0.0f});
 
     volcanoShader.use();
@@ -213,57 +43,13 @@ void initGLParams(const SIM_State& sim, const gil::RenderingWindow& window, gil:
 
 void initSPH(SIM_State& sim)
 {
-    Particle p;
-    gil::Vec3f pos;
-    for(pos.x = sim.margin; pos.x < sim.boundaryWidth * 0.5f; pos.x += sim.supportRadius * 0.6f)
-	{
-		for(pos.y = sim.margin; pos.y < sim.boundaryHeight * 0.5f; pos.y += sim.supportRadius * 0.6f)
-		{
-			for(pos.z = sim.margin; pos.z < sim.boundaryDepth * 0.5f; pos.z += sim.supportRadius * 0.6f)
-			{
-				p.r = pos;
-                p.v = {0.0f, 0.0f, 0.0f};
-                sim.particles.push_back(std::move(p));
-
-                // Positions
-                sim.vertexData.push_back(0.0f);
-                sim.vertexData.push_back(0.0f);
-                sim.vertexData.push_back(0.0f);
-                // Colors
-                sim.vertexData.push_back(1.0f);
-                sim.vertexData.push_back(0.13f);
-                sim.vertexData.push_back(0.0f);
-			}
-		}
-	}
-    sim.boundaryWidth  *= 0.6f;
-    sim.boundaryHeight *= 0.6f;
-    sim.boundaryDepth  *= 0.6f;
-    sim.stride = 6;
-
-    glGenVertexArrays(1, &sim.VAO);
-    glGenBuffers(1, &sim.VBO);
-
-    glBindVertexArray(sim.VAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, sim.VBO);
-    glBufferData(GL_ARRAY_BUFFER, sim.stride * sim.particles.size() * sizeof(float), sim.vertexData.data(), GL_STATIC_DRAW);
-
-    // Position Attrib
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sim.stride * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    // Particle Color
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sim.stride * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-
-    glBindVertexArray(0);
+    sim.stream.init(sim.particles.size(), sim.simulation.frames());
 
     std::cout << "Initialized with " << sim.particles.size() << " particles" << std::endl;
 }
 // ---------------------------------------------------------------------------------------------------------------------------------------------------------------
 
-int main()
+int main(int argc, char* argv[])
 {
     gil::RenderingWindow window {800, 600, "SPH"};
     if(!window.isReady())
@@ -280,22 +66,26 @@ int main()
 
     SIM_State sim;
 
-    sim.timeStep = 0.01f;
-    sim.restDensity = 3000.29f;
-    sim.mass = 0.02f;
-    sim.viscosity = 3.5f;
-    sim.surfaceTension = 0.0728f;
-    sim.threshold = 7.065f;
-    sim.gasStiffness = 3.0f;
-    sim.restitution = 0.0f;
-    sim.supportRadius = 0.0457f;
-
-    sim.margin = sim.supportRadius;
-    sim.damping = -0.5f;
-    sim.boundaryWidth = 0.65f;
-    sim.boundaryHeight = 0.65f;
-    sim.boundaryDepth = 0.65f;
-
+    // Usage: volcano [pressure solver] [integrator] [scene file] [section.key=value ...]
+    std::vector<std::string> overrides;
+    const std::vector<std::string> args {sceneArguments(argc, argv, overrides)};
+    std::string error;
+    if(!loadScene(sim, args.size() > 2 ? args[2] : "volcano", overrides, error))
+    {
+        std::cerr << "Cannot load scene: " << error << std::endl;
+        return EXIT_FAILURE;
+    }
+    if(args.size() > 0 && !setPressureSolver(sim, args[0]))
+    {
+        std::cerr << "Unknown pressure solver '" << args[0] << "' (available: " << PRESSURE_SOLVER_NAMES << ")" << std::endl;
+        return EXIT_FAILURE;
+    }
+    if(args.size() > 1 && !setIntegrator(sim, args[1]))
+    {
+        std::cerr << "Unknown integrator '" << args[1] << "' (available: " << INTEGRATOR_NAMES << ")" << std::endl;
+        return EXIT_FAILURE;
+    }
+    initSolver(sim);
     initSPH(sim);
 
     // ---------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -313,6 +103,9 @@ int main()
     gil::Model volcano("models/volcano.obj", nullptr, true, false);
     glm::vec3 volcanoPos {0.0f, -2.0f, 0.0f};
 
+    // Simulated time follows the wall clock, catching up with up to 8 steps per snapshot
+    sim.simulation.start(sim, 1.0, 8);
+
     while(window.isActive())
     {
         window.pollEvents();
@@ -336,76 +129,10 @@ int main()
         }
 
         // ---------------------------------------------------------------------------------------------------------------------------------------------------------------
-        // Compute Mass-Density and Pressure
+        // Simulation Step
         // ---------------------------------------------------------------------------------------------------------------------------------------------------------------
-        for(unsigned int i = 0; i < sim.particles.size(); ++i)
-        {
-            Particle& pi = sim.particles[i];
-
-            pi.density = 0;
-            for(unsigned int j = 0; j < sim.particles.size(); ++j)
-            {
-                Particle& pj = sim.particles[j];
-                gil::Vec3f r {pi.r - pj.r};
-
-                if(gil::module(r) < sim.supportRadius)
-                {
-                    pi.density += sim.mass * poly6DefaultKernel(r, sim.supportRadius);
-                }
-            }
-            pi.pressure = sim.gasStiffness * (sim.particles[i].density - sim.restDensity);
-            // ---------------------------------------------------------------------------------------------------------------------------------------------------------------
-        }
-
-        // ---------------------------------------------------------------------------------------------------------------------------------------------------------------
-        // Compute Internal and External Forces
-        // ---------------------------------------------------------------------------------------------------------------------------------------------------------------
-        for(unsigned int i = 0; i < sim.particles.size(); ++i)
-        {
-            Particle& pi = sim.particles[i];
-
-            gil::Vec3f pressureForce  {0.0f, 0.0f, 0.0f};
-            gil::Vec3f viscosityForce {0.0f, 0.0f, 0.0f};
-            gil::Vec3f sfTensionForce {0.0f, 0.0f, 0.0f};
-            gil::Vec3f gravityForce   {0.0f, -gil::constants::GAL, 0.0f};
-
-            float colorLaplacian {0.0f};
-            gil::Vec3f surfaceNormal {0.0f, 0.0f, 0.0f};
-
-            for(unsigned int j = 0; j < sim.particles.size(); ++j)
-            {
-                if(&pi == &sim.particles[j])
-                {
-                    continue;
-                }
-
-                Particle& pj = sim.particles[j];
-                gil::Vec3f r {pi.r - pj.r};
-
-                if(gil::module(r) < sim.supportRadius)
-                {
-                    pressureForce  += ((pi.pressure / SQD(pi.density)) + (pj.pressure / SQD(pj.density))) * sim.mass * spikyGradientKernel(r, sim.supportRadius);
-                    viscosityForce += (pj.v - pi.v) * (sim.mass / pj.density) * viscosityLaplacianKernel(r, sim.supportRadius);
-                    surfaceNormal  += (sim.mass / pj.density) * poly6GradientKernel(r, sim.supportRadius);
-                    colorLaplacian += (sim.mass / pj.density) * poly6LaplacianKernel(r, sim.supportRadius);
-                }
-            }
-            pressureForce  *= -pi.density;
-            viscosityForce *= sim.viscosity;
-            gravityForce *= sim.restDensity;
-
-            if(gil::module(surfaceNormal) >= sim.threshold)
-            {
-                sfTensionForce = -sim.surfaceTension * colorLaplacian * gil::normalize(surfaceNormal);
-            }
-            pi.f = pressureForce + viscosityForce + gravityForce + sfTensionForce;
-        }
-        // ---------------------------------------------------------------------------------------------------------------------------------------------------------------
-
-        // ---------------------------------------------------------------------------------------------------------------------------------------------------------------
-        // Integrate by Euler 1th Order
-        // ---------------------------------------------------------------------------------------------------------------------------------------------------------------
-        leapFrogIntegrate(sim);
+        // Steps run on the simulation thread, which packs them straight into the stream; take its newest frame, if any
+        sim.stream.update(sim.simulation.frames());
         // ---------------------------------------------------------------------------------------------------------------------------------------------------------------
 
         // ---------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -431,21 +158,8 @@ int main()
 
         shader.use();
         shader.setMat4("view", view);
-        for(unsigned int i = 0; i < sim.particles.size(); ++i)
-        {
-            Particle& pi = sim.particles[i];
-
-            model = glm::mat4(1.0f);
-            model = glm::translate(model, glm::vec3{pi.r.x, pi.r.y, pi.r.z});
-            shader.setMat4("model", model);
-
-            float zColorDepth {pi.r.z / sim.boundaryDepth};
-            shader.setVec3("colorDepth", {zColorDepth, zColorDepth, zColorDepth});
-
-            glBindVertexArray(sim.VAO);
-                glDrawArrays(GL_POINTS, 0, sim.particles.size());
-            glBindVertexArray(0);
-        }
+        shader.setMat4("model", glm::mat4(1.0f));
+        sim.stream.draw();
 
         window.swapBuffers();
         // ---------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -453,8 +167,8 @@ int main()
         timer.tick();
     }
 
-    glDeleteVertexArrays(1, &sim.VAO);
-    glDeleteBuffers(1, &sim.VBO);
+    sim.simulation.stop();
+    sim.stream.destroy();
 
     return 0;
 }